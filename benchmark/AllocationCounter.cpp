@@ -0,0 +1,19 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> GlobalAllocationCount = 0;
+
+uint64_t AllocationCounter::Get() { return GlobalAllocationCount.load(std::memory_order_relaxed); }
+
+void *operator new(std::size_t size) {
+    GlobalAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (const auto ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
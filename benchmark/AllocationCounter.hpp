@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts the calls to the global allocation functions, so that benchmarks can report how many heap allocations they
+// make. The replacement allocation functions are defined in the corresponding cpp file, which is linked into the
+// benchmark executable only.
+class AllocationCounter {
+public:
+    static uint64_t Get();
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+
+namespace grid_board_game {
+// A set of grids stored in 64-bit words, so that the grids around a position can be read as one word instead of one by
+// one. The grid at `position` is bit `position % 64` of word `position / 64`, and the bits beyond `Size` are always 0.
+template <unsigned int Size>
+class BitBoard {
+public:
+    static constexpr unsigned int WordCount = (Size + 63) / 64;
+
+private:
+    // The bits of the last word that are grids
+    static constexpr uint64_t LastWordMask = Size % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (Size % 64)) - 1;
+
+    std::array<uint64_t, WordCount> m_Words = {};
+
+    static unsigned int CountTrailingZeros(uint64_t word) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(word);
+#else
+        unsigned int count = 0;
+        for (; !(word & 1); word >>= 1)
+            ++count;
+        return count;
+#endif
+    }
+
+public:
+    constexpr bool operator[](unsigned int position) const { return (m_Words[position / 64] >> (position % 64)) & 1; }
+    constexpr void Set(unsigned int position) { m_Words[position / 64] |= uint64_t(1) << (position % 64); }
+    constexpr void Reset(unsigned int position) { m_Words[position / 64] &= ~(uint64_t(1) << (position % 64)); }
+
+    constexpr uint64_t GetWord(unsigned int idx) const { return m_Words[idx]; }
+
+    unsigned int Count() const {
+        unsigned int count = 0;
+        for (const auto word : m_Words)
+#if defined(__GNUC__)
+            count += __builtin_popcountll(word);
+#else
+            count += std::bitset<64>(word).count();
+#endif
+        return count;
+    }
+    constexpr bool Any() const {
+        for (const auto word : m_Words)
+            if (word != 0)
+                return true;
+        return false;
+    }
+
+    // The first set grid from `position`, or `Size` if there is none. The set grids are visited in order by
+    // `for (auto pos = board.FindNext(0); pos < Size; pos = board.FindNext(pos + 1))`
+    unsigned int FindNext(unsigned int position) const {
+        if (position >= Size)
+            return Size;
+        auto idx = position / 64;
+        auto word = m_Words[idx] & (~uint64_t(0) << (position % 64));
+        while (word == 0) {
+            if (++idx == WordCount)
+                return Size;
+            word = m_Words[idx];
+        }
+        return idx * 64 + CountTrailingZeros(word);
+    }
+
+    // The 64 grids from `start` as the bits of a word, the grids before 0 or beyond `Size` are 0
+    constexpr uint64_t GetWindow(int start) const {
+        // Rounded down, so that `bit` is in [0, 64) even if `start` is negative
+        const auto word = start >= 0 ? start / 64 : -((63 - start) / 64);
+        const auto bit = static_cast<unsigned int>(start - word * 64);
+        const auto getWord = [&](int idx) { return idx >= 0 && idx < int(WordCount) ? m_Words[idx] : 0; };
+        // Shifting a 64-bit word by 64 is undefined
+        return bit == 0 ? getWord(word) : getWord(word) >> bit | getWord(word + 1) << (64 - bit);
+    }
+
+    // Move every grid `offset` positions forward (or backward if negative), the grids moved off either end are dropped.
+    // Grids are not aware of rows, so the caller masks out the ones that wrapped around into another row
+    constexpr BitBoard Shift(int offset) const {
+        BitBoard result;
+        for (unsigned int idx = 0; idx < WordCount; ++idx)
+            result.m_Words[idx] = GetWindow(int(idx * 64) - offset);
+        result.m_Words[WordCount - 1] &= LastWordMask;
+        return result;
+    }
+
+    constexpr BitBoard &operator&=(const BitBoard &other) {
+        for (unsigned int idx = 0; idx < WordCount; ++idx)
+            m_Words[idx] &= other.m_Words[idx];
+        return *this;
+    }
+    constexpr BitBoard &operator|=(const BitBoard &other) {
+        for (unsigned int idx = 0; idx < WordCount; ++idx)
+            m_Words[idx] |= other.m_Words[idx];
+        return *this;
+    }
+    // The bits beyond `Size` stay 0
+    constexpr BitBoard operator~() const {
+        BitBoard result;
+        for (unsigned int idx = 0; idx < WordCount; ++idx)
+            result.m_Words[idx] = ~m_Words[idx];
+        result.m_Words[WordCount - 1] &= LastWordMask;
+        return result;
+    }
+    friend constexpr BitBoard operator&(BitBoard left, const BitBoard &right) { return left &= right; }
+    friend constexpr BitBoard operator|(BitBoard left, const BitBoard &right) { return left |= right; }
+
+    friend constexpr bool operator==(const BitBoard &left, const BitBoard &right) {
+        for (unsigned int idx = 0; idx < WordCount; ++idx)
+            if (left.m_Words[idx] != right.m_Words[idx])
+                return false;
+        return true;
+    }
+    friend constexpr bool operator!=(const BitBoard &left, const BitBoard &right) { return !(left == right); }
+};
+} // namespace grid_board_game
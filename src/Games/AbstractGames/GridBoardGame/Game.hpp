@@ -2,21 +2,67 @@
 
 #include "../../../Utilities/Utilities.hpp"
 #include "../../Game.hpp"
+#include "BitBoard.hpp"
 #include <array>
-#include <bitset>
+#include <new>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
 
 namespace grid_board_game {
 template <unsigned char RowCount, unsigned char ColCount, unsigned char PlayerCount>
 class Game : public ::Game {
+    static_assert(PlayerCount <= ::Game::MaxPlayerCount, "The results of the game do not fit in `Game::Result`");
+
 public:
     using PosType = Util::UIntByValue<RowCount * ColCount>;
+    using BitBoard = grid_board_game::BitBoard<RowCount * ColCount>;
+
+private:
+    // The grids in the columns before each column, used to drop the grids that wrapped around into another row
+    static constexpr auto LeftColumns = [] {
+        std::array<BitBoard, ColCount + 1> masks = {};
+        for (unsigned char col = 1; col <= ColCount; ++col) {
+            masks[col] = masks[col - 1];
+            for (unsigned char row = 0; row < RowCount; ++row)
+                masks[col].Set(row * ColCount + col - 1);
+        }
+        return masks;
+    }();
+
+public:
+    // Move every grid by the offsets, the grids moved off the board are dropped
+    static constexpr BitBoard ShiftGrids(const BitBoard &board, int rowOffset, int colOffset) {
+        if (colOffset >= ColCount || -colOffset >= ColCount)
+            return {};
+        const auto shifted = board.Shift(rowOffset * ColCount + colOffset);
+        return colOffset >= 0 ? shifted & ~LeftColumns[colOffset] : shifted & LeftColumns[ColCount + colOffset];
+    }
 
     struct State : public ::Game::State {
+    private:
+        // Zobrist keys, one random number for each player on each grid. The key of a board is the XOR of the keys of
+        // its occupied grids, so it can be updated with one XOR whenever a grid changes. The numbers are generated by
+        // SplitMix64 at compile time, so the hashes are the same across runs
+        static constexpr auto ZobristKeys = [] {
+            std::array<std::array<uint64_t, RowCount * ColCount>, PlayerCount> keys = {};
+            uint64_t seed = 0;
+            for (auto &playerKeys : keys)
+                for (auto &key : playerKeys) {
+                    auto z = (seed += 0x9e3779b97f4a7c15);
+                    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                    key = z ^ (z >> 31);
+                }
+            return keys;
+        }();
+
+        // The Zobrist key of `BitBoards`, so `BitBoards` must only be modified by `SetGrid` and `ClearGrid`
+        uint64_t m_BoardKey = 0;
+
+    public:
         // Since alignof(State) is 8 most of the time, using a smaller integer type will not save memory
         uint64_t MoveCount = 0;
-        std::array<std::bitset<RowCount * ColCount>, PlayerCount> BitBoards = {};
+        std::array<BitBoard, PlayerCount> BitBoards = {};
 
         State() = default;
         explicit State(const nlohmann::json &data) : MoveCount(data["moveCount"]) {
@@ -47,26 +93,55 @@ public:
         }
         void SetGrid(PosType position, unsigned char playerIdx, bool clearOtherBits) {
             if (clearOtherBits)
-                for (auto &bitBoard : BitBoards)
-                    bitBoard[position] = false;
-            BitBoards[playerIdx][position] = true;
+                for (unsigned char idx = 0; idx < PlayerCount; ++idx)
+                    if (idx != playerIdx && BitBoards[idx][position]) {
+                        BitBoards[idx].Reset(position);
+                        m_BoardKey ^= ZobristKeys[idx][position];
+                    }
+            if (!BitBoards[playerIdx][position]) {
+                BitBoards[playerIdx].Set(position);
+                m_BoardKey ^= ZobristKeys[playerIdx][position];
+            }
+        }
+        // The grids occupied by any player
+        BitBoard GetOccupied() const {
+            auto occupied = BitBoards[0];
+            for (unsigned char playerIdx = 1; playerIdx < PlayerCount; ++playerIdx)
+                occupied |= BitBoards[playerIdx];
+            return occupied;
+        }
+        // Empty the grid, the opposite of `SetGrid`
+        void ClearGrid(PosType position) {
+            for (unsigned char playerIdx = 0; playerIdx < PlayerCount; ++playerIdx)
+                if (BitBoards[playerIdx][position]) {
+                    BitBoards[playerIdx].Reset(position);
+                    m_BoardKey ^= ZobristKeys[playerIdx][position];
+                }
         }
         std::array<std::array<unsigned char, ColCount>, RowCount> GetBoard() const {
-            std::array<std::array<unsigned char, ColCount>, RowCount> board;
-            for (unsigned char rowIdx = 0; rowIdx < RowCount; ++rowIdx)
-                for (unsigned char colIdx = 0; colIdx < ColCount; ++colIdx)
-                    board[rowIdx][colIdx] = GetGrid(rowIdx * ColCount + colIdx);
+            std::array<std::array<unsigned char, ColCount>, RowCount> board = {};
+            for (unsigned char playerIdx = 0; playerIdx < PlayerCount; ++playerIdx)
+                for (auto position = BitBoards[playerIdx].FindNext(0); position < RowCount * ColCount;
+                     position = BitBoards[playerIdx].FindNext(position + 1))
+                    board[position / ColCount][position % ColCount] = playerIdx + 1;
             return board;
         }
 
+        // Comparing the keys first rejects almost all unequal states without looking at the boards
         friend bool operator==(const State &left, const State &right) {
-            return left.MoveCount == right.MoveCount && left.BitBoards == right.BitBoards;
+            return left.m_BoardKey == right.m_BoardKey && left.MoveCount == right.MoveCount &&
+                   left.BitBoards == right.BitBoards;
         }
 
         virtual std::unique_ptr<::Game::State> Clone() const override { return std::make_unique<State>(*this); }
+        virtual std::size_t GetSize() const override { return sizeof(State); }
+        virtual ::Game::State *CloneAt(void *memory) const override { return new (memory) State(*this); }
+        virtual void CopyFrom(const ::Game::State &state) override { *this = static_cast<const State &>(state); }
         virtual bool Equal(const ::Game::State &state) const override {
             return *this == static_cast<const State &>(state);
         }
+        // `MoveCount` is modified directly by the games, so it is mixed in here rather than kept in the key
+        virtual uint64_t Hash() const override { return m_BoardKey ^ (MoveCount * 0x9e3779b97f4a7c15); }
         virtual nlohmann::json GetJson() const override { return {{"moveCount", MoveCount}, {"board", GetBoard()}}; }
     };
 
@@ -92,18 +167,21 @@ public:
         friend bool operator==(const Action &left, const Action &right) { return left.Position == right.Position; }
 
         virtual std::unique_ptr<::Game::Action> Clone() const override { return std::make_unique<Action>(*this); }
+        virtual std::size_t GetSize() const override { return sizeof(Action); }
+        virtual ::Game::Action *CloneAt(void *memory) const override { return new (memory) Action(*this); }
         virtual bool Equal(const ::Game::Action &action) const override {
             return *this == static_cast<const Action &>(action);
         }
         virtual nlohmann::json GetJson() const override { return {{"row", GetRow()}, {"col", GetCol()}}; }
     };
 
-    virtual std::unique_ptr<::Game::State> CreateDefaultState() const override { return std::make_unique<State>(); }
-    virtual std::unique_ptr<::Game::State> CreateState(const nlohmann::json &data) const override {
-        return std::make_unique<State>(data);
-    }
-    virtual std::unique_ptr<::Game::Action> CreateAction(const nlohmann::json &data) const override {
-        return std::make_unique<Action>(data);
+    virtual StateValue CreateDefaultState() const override { return StateValue(State()); }
+    virtual StateValue CreateState(const nlohmann::json &data) const override { return StateValue(State(data)); }
+    virtual ActionValue CreateAction(const nlohmann::json &data) const override { return ActionValue(Action(data)); }
+
+    virtual unsigned int GetActionIndexCount() const override { return RowCount * ColCount; }
+    virtual unsigned int GetActionIndex(const ::Game::Action &action) const override {
+        return static_cast<const Action &>(action).Position;
     }
 
     virtual bool IsValidAction(const ::Game::State &, const ::Game::Action &action_) const override {
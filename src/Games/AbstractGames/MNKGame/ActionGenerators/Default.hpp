@@ -24,22 +24,39 @@ public:
 
     explicit Default(const ::Game &game) : ActionGenerator(game) {}
 
+    // There is no data to update, so there is nothing to save
+    virtual std::unique_ptr<ActionGenerator::UndoData> CreateUndoData() const override {
+        return std::make_unique<ActionGenerator::UndoData>();
+    }
+
     virtual std::unique_ptr<ActionGenerator::Iterator> FirstIterator(const ActionGenerator::Data &data,
                                                                      const ::Game::State &state) const override {
         auto iterator = std::make_unique<Iterator>(-1);
-        [[maybe_unused]] const auto isValid = NextIterator(data, state, *iterator);
-        assert(isValid);
+        ResetIterator(data, state, *iterator);
         return iterator;
     }
 
+    virtual void ResetIterator(const ActionGenerator::Data &data, const ::Game::State &state,
+                               ActionGenerator::Iterator &iterator) const override {
+        // The position wraps around to zero when incremented by `NextIterator`
+        static_cast<Iterator &>(iterator).Action.Position = -1;
+        [[maybe_unused]] const auto isValid = NextIterator(data, state, iterator);
+        assert(isValid);
+    }
+
     virtual bool NextIterator(const ActionGenerator::Data &, const ::Game::State &state_,
                               ActionGenerator::Iterator &iterator_) const override {
         const auto &state = static_cast<const typename Game<RowCount, ColCount, Renju>::State &>(state_);
         auto &iterator = static_cast<Iterator &>(iterator_);
-        for (++iterator.Action.Position; iterator.Action.Position < RowCount * ColCount; ++iterator.Action.Position)
-            if (state.GetGrid(iterator.Action.Position) == 0)
-                return true;
-        return false;
+        // Incremented before the conversion, so that it wraps around from -1 in `PosType`
+        ++iterator.Action.Position;
+        iterator.Action.Position = (~state.GetOccupied()).FindNext(iterator.Action.Position);
+        return iterator.Action.Position < RowCount * ColCount;
+    }
+
+    virtual unsigned int GetActionCount(const ActionGenerator::Data &, const ::Game::State &state_) const override {
+        const auto &state = static_cast<const typename Game<RowCount, ColCount, Renju>::State &>(state_);
+        return RowCount * ColCount - state.GetOccupied().Count();
     }
 
     virtual const ::Game::Action &GetActionFromIterator(const ActionGenerator::Data &, const ::Game::State &,
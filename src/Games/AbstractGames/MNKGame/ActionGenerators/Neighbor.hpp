@@ -2,18 +2,23 @@
 
 #include "../../../ActionGenerator.hpp"
 #include "../Game.hpp"
+#include <algorithm>
+#include <array>
 
 namespace m_n_k_game::action_generator {
 template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
 class Neighbor : public ActionGenerator {
 private:
+    using BitBoard = typename Game<RowCount, ColCount, Renju>::BitBoard;
+
     unsigned char m_Range;
+    // The grids within range of each grid
+    std::array<BitBoard, RowCount * ColCount> m_Windows = {};
 
 public:
     struct Data : public ActionGenerator::Data {
-        std::bitset<RowCount * ColCount> InRange;
-        std::array<unsigned char, RowCount> CountInRow = {};
-        typename Game<RowCount, ColCount, Renju>::PosType TotalCount = 0;
+        // The empty grids within range of a stone, and the center if it's empty
+        BitBoard InRange;
 
         friend bool operator==(const Data &left, const Data &right) { return left.InRange == right.InRange; }
 
@@ -23,6 +28,10 @@ public:
         }
     };
 
+    struct UndoData : public ActionGenerator::UndoData {
+        BitBoard InRange;
+    };
+
     struct Iterator : public ActionGenerator::Iterator {
         typename Game<RowCount, ColCount, Renju>::Action Action;
 
@@ -38,63 +47,86 @@ public:
         }
     };
 
-    explicit Neighbor(const ::Game &game, unsigned char range) : ActionGenerator(game), m_Range(range) {}
+    explicit Neighbor(const ::Game &game, unsigned char range) : ActionGenerator(game), m_Range(range) {
+        for (unsigned int position = 0; position < RowCount * ColCount; ++position) {
+            const int row = position / ColCount, col = position % ColCount;
+            for (int x = std::max(0, row - range); x <= std::min(RowCount - 1, row + range); ++x)
+                for (int y = std::max(0, col - range); y <= std::min(ColCount - 1, col + range); ++y)
+                    m_Windows[position].Set(x * ColCount + y);
+        }
+    }
 
-    virtual std::unique_ptr<ActionGenerator::Data> CreateData(const ::Game::State &state_) const override {
-        const auto &state = static_cast<const typename Game<RowCount, ColCount, Renju>::State &>(state_);
+    virtual std::unique_ptr<ActionGenerator::Data> CreateData(const ::Game::State &state) const override {
         auto data = std::make_unique<Data>();
-        data->InRange[RowCount / 2 * ColCount + ColCount / 2] = true;
-        data->CountInRow[RowCount / 2] = 1;
-        for (typename Game<RowCount, ColCount, Renju>::Action action(0); action.Position < RowCount * ColCount;
-             ++action.Position)
-            if (state.GetGrid(action.Position) != 0)
-                UpdateData(*data, state, action);
+        ResetData(*data, state);
         return data;
     }
 
+    virtual void ResetData(ActionGenerator::Data &data_, const ::Game::State &state_) const override {
+        auto &data = static_cast<Data &>(data_);
+        const auto &state = static_cast<const typename Game<RowCount, ColCount, Renju>::State &>(state_);
+        const auto occupied = state.GetOccupied();
+        // Spread the stones over the columns within range, and then spread the result over the rows within range
+        const int range = std::min<int>(m_Range, std::max(RowCount, ColCount));
+        auto inColumns = occupied;
+        for (int offset = 1; offset <= range; ++offset)
+            inColumns |= Game<RowCount, ColCount, Renju>::ShiftGrids(occupied, 0, offset) |
+                         Game<RowCount, ColCount, Renju>::ShiftGrids(occupied, 0, -offset);
+        data.InRange = inColumns;
+        for (int offset = 1; offset <= range; ++offset)
+            data.InRange |= Game<RowCount, ColCount, Renju>::ShiftGrids(inColumns, offset, 0) |
+                            Game<RowCount, ColCount, Renju>::ShiftGrids(inColumns, -offset, 0);
+        data.InRange.Set(RowCount / 2 * ColCount + ColCount / 2);
+        data.InRange &= ~occupied;
+    }
+
     virtual void UpdateData(ActionGenerator::Data &data_, const ::Game::State &state_,
                             const ::Game::Action &action_) const override {
         auto &data = static_cast<Data &>(data_);
         const auto &state = static_cast<const typename Game<RowCount, ColCount, Renju>::State &>(state_);
         const auto &action = static_cast<const typename Game<RowCount, ColCount, Renju>::Action &>(action_);
-        const auto row = action.GetRow(), col = action.GetCol();
-        const unsigned char rowBegin = std::max(0, row - m_Range), rowEnd = std::min(RowCount - 1, row + m_Range);
-        const unsigned char colBegin = std::max(0, col - m_Range), colEnd = std::min(ColCount - 1, col + m_Range);
-        for (auto rowIdx = rowBegin; rowIdx <= rowEnd; ++rowIdx) {
-            ++data.CountInRow[rowIdx];
-            for (auto colIdx = colBegin; colIdx <= colEnd; ++colIdx)
-                if (state.GetGrid(rowIdx * ColCount + colIdx) == 0)
-                    data.InRange[rowIdx * ColCount + colIdx] = true;
-        }
-        data.InRange[action.Position] = false;
-        --data.CountInRow[row];
+        data.InRange |= m_Windows[action.Position];
+        data.InRange &= ~state.GetOccupied();
+    }
+
+    virtual std::unique_ptr<ActionGenerator::UndoData> CreateUndoData() const override {
+        return std::make_unique<UndoData>();
+    }
+    virtual void SaveUndoData(const ActionGenerator::Data &data, ActionGenerator::UndoData &undoData) const override {
+        static_cast<UndoData &>(undoData).InRange = static_cast<const Data &>(data).InRange;
+    }
+    virtual void UndoUpdateData(ActionGenerator::Data &data, const ActionGenerator::UndoData &undoData) const override {
+        static_cast<Data &>(data).InRange = static_cast<const UndoData &>(undoData).InRange;
     }
 
     virtual std::unique_ptr<ActionGenerator::Iterator> FirstIterator(const ActionGenerator::Data &data,
                                                                      const ::Game::State &state) const override {
         auto iterator = std::make_unique<Iterator>(-1);
-        [[maybe_unused]] const auto isValid = NextIterator(data, state, *iterator);
-        assert(isValid);
+        ResetIterator(data, state, *iterator);
         return iterator;
     }
 
+    virtual void ResetIterator(const ActionGenerator::Data &data, const ::Game::State &state,
+                               ActionGenerator::Iterator &iterator) const override {
+        // The position wraps around to zero when incremented by `NextIterator`
+        static_cast<Iterator &>(iterator).Action.Position = -1;
+        [[maybe_unused]] const auto isValid = NextIterator(data, state, iterator);
+        assert(isValid);
+    }
+
     virtual bool NextIterator(const ActionGenerator::Data &data_, const ::Game::State &,
                               ActionGenerator::Iterator &iterator_) const override {
         const auto &data = static_cast<const Data &>(data_);
         auto &iterator = static_cast<Iterator &>(iterator_);
+        // Incremented before the conversion, so that it wraps around from -1 in `PosType`
         ++iterator.Action.Position;
-        for (auto col = iterator.Action.GetCol(); col < ColCount; ++col, ++iterator.Action.Position)
-            if (data.InRange[iterator.Action.Position])
-                return true;
-        assert(iterator.Action.Position % ColCount == 0);
-        for (auto row = iterator.Action.GetRow(); row < RowCount; ++row)
-            if (data.CountInRow[row] == 0)
-                iterator.Action.Position += ColCount;
-            else
-                for (unsigned char col = 0; col < ColCount; ++col, ++iterator.Action.Position)
-                    if (data.InRange[iterator.Action.Position])
-                        return true;
-        return false;
+        iterator.Action.Position = data.InRange.FindNext(iterator.Action.Position);
+        return iterator.Action.Position < RowCount * ColCount;
+    }
+
+    virtual unsigned int GetActionCount(const ActionGenerator::Data &data_, const ::Game::State &) const override {
+        const auto &data = static_cast<const Data &>(data_);
+        return data.InRange.Count();
     }
 
     virtual const ::Game::Action &GetActionFromIterator(const ActionGenerator::Data &, const ::Game::State &,
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "Game.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace m_n_k_game {
+// Random playouts of many m,n,k-games at once, the same as the random move player with the default action generator, or
+// with the neighbor action generator if `range` is given. The boards are kept as 64-bit words laid out lane by lane
+// (all lanes of word 0, then all lanes of word 1, ...), and the lanes take turns to make one move each, so the playouts
+// advance in lockstep and their dependency chains overlap. A move is chosen by counting the candidate grids with
+// `popcount` and selecting the n-th set bit (with `pdep` if BMI2 is enabled), and the candidates of the neighbor action
+// generator are updated by OR-ing a precomputed window, so no grid is visited one by one. A lane is refilled with the
+// next state as soon as its game is over.
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju, unsigned int Lanes = 8>
+class BatchedRollout {
+public:
+    using State = typename Game<RowCount, ColCount, Renju>::State;
+    // The score of each player, 1 for the winner, 0.5 for both players if it's a draw
+    using Result = std::array<float, 2>;
+
+private:
+    static constexpr unsigned int GridCount = RowCount * ColCount;
+    static constexpr unsigned int WordCount = (GridCount + 63) / 64;
+    using Board = std::array<uint64_t, WordCount>;
+    template <typename T>
+    using LaneArray = std::array<T, Lanes>;
+
+    // Candidate grids added by a move on each grid, empty if all empty grids are candidates
+    std::array<Board, GridCount> m_Windows = {};
+    bool m_AllGrids;
+
+    std::array<std::array<LaneArray<uint64_t>, WordCount>, 2> m_Stones;
+    std::array<LaneArray<uint64_t>, WordCount> m_Candidates;
+    LaneArray<unsigned int> m_MoveCounts;
+    // The index of the state that is played in each lane, or `std::size_t(-1)` if the lane is idle
+    LaneArray<std::size_t> m_Sources;
+
+    static bool GetBit(const std::array<LaneArray<uint64_t>, WordCount> &board, unsigned int lane, unsigned int pos) {
+        return (board[pos / 64][lane] >> (pos % 64)) & 1;
+    }
+
+    // Index of the `idx`-th set bit of the word
+    static unsigned int SelectBit(uint64_t word, unsigned int idx) {
+#if defined(__BMI2__)
+        return _tzcnt_u64(_pdep_u64(uint64_t(1) << idx, word));
+#else
+        while (idx--)
+            word &= word - 1;
+        unsigned int pos = 0;
+        while (!(word & 1)) {
+            word >>= 1;
+            ++pos;
+        }
+        return pos;
+#endif
+    }
+
+    static unsigned int PopCount(uint64_t word) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(word);
+#else
+        return std::bitset<64>(word).count();
+#endif
+    }
+
+    void LoadLane(unsigned int lane, const State &state, std::size_t source) {
+        m_Sources[lane] = source;
+        m_MoveCounts[lane] = state.MoveCount;
+        Board occupied = {};
+        for (unsigned char player = 0; player < 2; ++player)
+            for (unsigned int word = 0; word < WordCount; ++word) {
+                m_Stones[player][word][lane] = state.BitBoards[player].GetWord(word);
+                occupied[word] |= m_Stones[player][word][lane];
+            }
+        Board candidates = {};
+        if (m_AllGrids) {
+            for (unsigned int word = 0; word < WordCount; ++word)
+                candidates[word] = ~occupied[word];
+            // Clear the bits beyond the last grid
+            if (GridCount % 64 != 0)
+                candidates[WordCount - 1] &= (uint64_t(1) << (GridCount % 64)) - 1;
+        } else {
+            // The same as `action_generator::Neighbor::ResetData`, the center is always a candidate if it's empty
+            constexpr unsigned int center = RowCount / 2 * ColCount + ColCount / 2;
+            candidates[center / 64] |= uint64_t(1) << (center % 64);
+            for (unsigned int pos = 0; pos < GridCount; ++pos)
+                if ((occupied[pos / 64] >> (pos % 64)) & 1)
+                    for (unsigned int word = 0; word < WordCount; ++word)
+                        candidates[word] |= m_Windows[pos][word];
+            for (unsigned int word = 0; word < WordCount; ++word)
+                candidates[word] &= ~occupied[word];
+        }
+        for (unsigned int word = 0; word < WordCount; ++word)
+            m_Candidates[word][lane] = candidates[word];
+    }
+
+    // Whether the stone just placed on `pos` completes a line of `Renju` stones
+    bool IsWin(unsigned int lane, unsigned char player, unsigned int pos) const {
+        static constexpr std::array<signed char, 4> DX = {0, 1, 1, 1};
+        static constexpr std::array<signed char, 4> DY = {1, 0, 1, -1};
+        const int row = pos / ColCount, col = pos % ColCount;
+        const auto &stones = m_Stones[player];
+        for (unsigned char dire = 0; dire < 4; ++dire) {
+            unsigned int count = 1;
+            for (int x = row + DX[dire], y = col + DY[dire];
+                 0 <= x && x < RowCount && 0 <= y && y < ColCount && GetBit(stones, lane, x * ColCount + y);
+                 x += DX[dire], y += DY[dire])
+                ++count;
+            for (int x = row - DX[dire], y = col - DY[dire];
+                 0 <= x && x < RowCount && 0 <= y && y < ColCount && GetBit(stones, lane, x * ColCount + y);
+                 x -= DX[dire], y -= DY[dire])
+                ++count;
+            if (count >= Renju)
+                return true;
+        }
+        return false;
+    }
+
+    // Make one random move in the lane, and return the result if the game is over
+    std::optional<Result> Step(unsigned int lane, std::minstd_rand &engine) {
+        unsigned int count = 0;
+        for (unsigned int word = 0; word < WordCount; ++word)
+            count += PopCount(m_Candidates[word][lane]);
+        assert(count > 0);
+        // Multiply and shift instead of `std::uniform_int_distribution`, which needs a division. The engine yields 31
+        // random bits, the bias is negligible for a few hundred candidates
+        auto idx = static_cast<unsigned int>((static_cast<uint64_t>(engine() - engine.min()) * count) >> 31);
+        unsigned int word = 0;
+        for (auto wordCount = PopCount(m_Candidates[0][lane]); idx >= wordCount;
+             wordCount = PopCount(m_Candidates[++word][lane]))
+            idx -= wordCount;
+        const auto pos = word * 64 + SelectBit(m_Candidates[word][lane], idx);
+        const unsigned char player = m_MoveCounts[lane] % 2;
+        m_Stones[player][pos / 64][lane] |= uint64_t(1) << (pos % 64);
+        ++m_MoveCounts[lane];
+        if (IsWin(lane, player, pos)) {
+            Result result = {};
+            result[player] = 1.0f;
+            return result;
+        }
+        if (m_MoveCounts[lane] == GridCount)
+            return Result{0.5f, 0.5f};
+        if (m_AllGrids)
+            m_Candidates[pos / 64][lane] &= ~(uint64_t(1) << (pos % 64));
+        else
+            for (unsigned int word = 0; word < WordCount; ++word)
+                m_Candidates[word][lane] = (m_Candidates[word][lane] | m_Windows[pos][word]) &
+                                           ~(m_Stones[0][word][lane] | m_Stones[1][word][lane]);
+        return std::nullopt;
+    }
+
+public:
+    // If `range` is not given, every empty grid is a candidate, otherwise only the empty grids within `range` of a stone
+    explicit BatchedRollout(std::optional<unsigned char> range) : m_AllGrids(!range) {
+        if (!range)
+            return;
+        for (unsigned int pos = 0; pos < GridCount; ++pos) {
+            const int row = pos / ColCount, col = pos % ColCount;
+            for (int x = std::max(0, row - *range); x <= std::min(RowCount - 1, row + *range); ++x)
+                for (int y = std::max(0, col - *range); y <= std::min(ColCount - 1, col + *range); ++y)
+                    m_Windows[pos][(x * ColCount + y) / 64] |= uint64_t(1) << ((x * ColCount + y) % 64);
+        }
+    }
+
+    // Play a random game from each of the `count` states, which must not be terminal, and write the results into
+    // `results`. The same state may be passed more than once
+    void Run(const State *const *states, std::size_t count, Result *results) {
+        auto &engine = Util::GetRandomEngine();
+        std::size_t next = 0;
+        unsigned int active = 0;
+        for (unsigned int lane = 0; lane < Lanes; ++lane) {
+            if (next < count) {
+                LoadLane(lane, *states[next], next);
+                ++next;
+                ++active;
+            } else
+                m_Sources[lane] = std::size_t(-1);
+        }
+        while (active > 0)
+            for (unsigned int lane = 0; lane < Lanes; ++lane) {
+                if (m_Sources[lane] == std::size_t(-1))
+                    continue;
+                const auto result = Step(lane, engine);
+                if (!result)
+                    continue;
+                results[m_Sources[lane]] = *result;
+                if (next < count) {
+                    LoadLane(lane, *states[next], next);
+                    ++next;
+                } else {
+                    m_Sources[lane] = std::size_t(-1);
+                    --active;
+                }
+            }
+    }
+};
+} // namespace m_n_k_game
@@ -1,10 +1,81 @@
 #pragma once
 
 #include "../GridBoardGame/Game.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace m_n_k_game {
 template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
 class Game : public grid_board_game::Game<RowCount, ColCount, 2> {
+private:
+    // How far the position of a grid moves by one step in each direction of the lines, which are the row, the column,
+    // the diagonal and the anti-diagonal
+    static constexpr std::array<unsigned char, 4> Steps = {1, ColCount, ColCount + 1, ColCount - 1};
+    // The grids up to `Renju - 1` steps away from a grid in all directions on either side are read from the board as one
+    // 64-bit window
+    static_assert((Renju - 1) * (ColCount + 1) <= 64, "The lines are too long to be read as one word");
+
+    // The grids 1 to `length` steps away from a grid, as bits of the window of the 64 grids after it (forward), or of
+    // the window of the 64 grids before it (backward)
+    static constexpr auto ForwardLineMasks = [] {
+        std::array<std::array<uint64_t, Renju>, 4> masks = {};
+        for (unsigned char dire = 0; dire < 4; ++dire)
+            for (unsigned int length = 1; length < Renju; ++length)
+                masks[dire][length] = masks[dire][length - 1] | uint64_t(1) << (length * Steps[dire] - 1);
+        return masks;
+    }();
+    static constexpr auto BackwardLineMasks = [] {
+        std::array<std::array<uint64_t, Renju>, 4> masks = {};
+        for (unsigned char dire = 0; dire < 4; ++dire)
+            for (unsigned int length = 1; length < Renju; ++length)
+                masks[dire][length] = masks[dire][length - 1] | uint64_t(1) << (64 - length * Steps[dire]);
+        return masks;
+    }();
+
+    // The number of stones in a row next to a grid on one side in a direction, up to `Renju - 1`. `window` holds the 64
+    // grids on that side, `masks` are the line masks of the direction on that side, and `maxLength` is the number of
+    // steps that can be taken before leaving the board, since the grids beyond the edge of a row wrap around
+    template <bool Forward>
+    static int CountStones(uint64_t window, const std::array<uint64_t, Renju> &masks, int maxLength) {
+#if defined(__BMI2__)
+        // Gather the grids of the line in the order of their positions, and count the stones in a row from the end
+        // next to the grid
+        const auto line = _pext_u64(window, masks[Renju - 1]);
+        const int length = Forward ? __builtin_ctzll(~line) : __builtin_clzll(~(line << (65 - Renju)));
+#else
+        int length = 0;
+        for (unsigned int idx = 1; idx < Renju; ++idx)
+            length += (window & masks[idx]) == masks[idx];
+#endif
+        return std::min(length, maxLength);
+    }
+
+    // Whether the stone on the grid is in a line of `Renju` stones of the same player. Each side of the grid is read from
+    // the bitboard as one word, and the stones in a row are counted with the masks of each direction, instead of
+    // walking from the grid one grid at a time
+    static bool IsInLine(const typename Game::State &state, unsigned char player, typename Game::PosType position) {
+        const int row = position / ColCount, col = position % ColCount;
+        const std::array<std::pair<int, int>, 4> maxLengths = {{
+            {ColCount - 1 - col, col},
+            {RowCount - 1 - row, row},
+            {std::min(RowCount - 1 - row, ColCount - 1 - col), std::min(row, col)},
+            {std::min(RowCount - 1 - row, col), std::min(row, ColCount - 1 - col)},
+        }};
+        const auto &stones = state.BitBoards[player];
+        const auto forward = stones.GetWindow(position + 1);
+        const auto backward = stones.GetWindow(position - 64);
+        for (unsigned char dire = 0; dire < 4; ++dire)
+            if (CountStones<true>(forward, ForwardLineMasks[dire], maxLengths[dire].first) +
+                    CountStones<false>(backward, BackwardLineMasks[dire], maxLengths[dire].second) + 1 >=
+                Renju)
+                return true;
+        return false;
+    }
+
 public:
     virtual unsigned char GetNextPlayer(const ::Game::State &state_) const {
         const auto &state = static_cast<const typename Game::State &>(state_);
@@ -18,9 +89,7 @@ public:
                state.GetGrid(action.Position) == 0;
     }
 
-    virtual std::optional<std::vector<float>> TakeAction(::Game::State &state_, const ::Game::Action &action_) const {
-        static constexpr std::array<signed char, 4> DX = {0, 1, 1, 1};
-        static constexpr std::array<signed char, 4> DY = {1, 0, 1, -1};
+    virtual std::optional<::Game::Result> TakeAction(::Game::State &state_, const ::Game::Action &action_) const {
         auto &state = static_cast<typename Game::State &>(state_);
         const auto &action = static_cast<const typename Game::Action &>(action_);
         assert(IsValidAction(state, action));
@@ -29,26 +98,9 @@ public:
         state.SetGrid(action.Position, nextPlayer, false);
         ++state.MoveCount;
         // Check if the game is over
-        const auto &bitset = state.BitBoards[nextPlayer];
-        const auto row = action.GetRow(), col = action.GetCol();
-        bool win = false;
-        for (unsigned char dire = 0; dire < 4; ++dire) {
-            unsigned char count = 0;
-            for (auto x = row + DX[dire], y = col + DY[dire];
-                 0 < x && x < RowCount && 0 < y && y < ColCount && bitset[x * ColCount + y];
-                 x += DX[dire], y += DY[dire])
-                ++count;
-            for (auto x = row - DX[dire], y = col - DY[dire];
-                 0 < x && x < RowCount && 0 < y && y < ColCount && bitset[x * ColCount + y];
-                 x -= DX[dire], y -= DY[dire])
-                ++count;
-            if (count + 1 >= Renju) {
-                win = true;
-                break;
-            }
-        }
+        const bool win = IsInLine(state, nextPlayer, action.Position);
         // Build result
-        std::optional<std::vector<float>> res;
+        std::optional<::Game::Result> res;
         if (win) {
             res.emplace(2, 0.0f);
             (*res)[nextPlayer] = 1.0f;
@@ -56,5 +108,14 @@ public:
             res.emplace(2, 0.5f);
         return res;
     }
+
+    virtual bool CanUndo() const { return true; }
+    virtual void UndoAction(::Game::State &state_, const ::Game::Action &action_) const {
+        auto &state = static_cast<typename Game::State &>(state_);
+        const auto &action = static_cast<const typename Game::Action &>(action_);
+        assert(state.MoveCount > 0 && state.GetGrid(action.Position) == (state.MoveCount - 1) % 2 + 1);
+        state.ClearGrid(action.Position);
+        --state.MoveCount;
+    }
 };
 } // namespace m_n_k_game
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Game.hpp"
+#include <array>
+#include <cstdint>
+
+namespace m_n_k_game {
+// Tracks the empty grids where a stone would make a line of `Renju` (a five) or an open line of `Renju - 1` with both
+// ends empty (an open four), for both players. For each empty grid and each direction, the `Renju - 1` grids on either
+// side are packed into a pattern with 2 bits per grid (empty, player 0, player 1, or off the board), and the threats a
+// pattern makes are looked up in a table computed once. A stone only changes the patterns of the grids within
+// `Renju - 1` on its 4 lines, so `Update` touches at most `8 * (Renju - 1)` patterns instead of scanning the board.
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
+class Threats {
+public:
+    enum Threat : unsigned char { Five, OpenFour };
+    using State = typename Game<RowCount, ColCount, Renju>::State;
+    using PosType = typename Game<RowCount, ColCount, Renju>::PosType;
+    using BitBoard = typename Game<RowCount, ColCount, Renju>::BitBoard;
+
+private:
+    static constexpr unsigned int GridCount = RowCount * ColCount;
+    static constexpr int Radius = Renju - 1;
+    static constexpr unsigned int PatternBits = 4 * Radius;
+    static_assert(PatternBits <= 20, "The pattern table would be too large");
+    enum Code : uint32_t { Empty, Player0, Player1, OffBoard };
+    static constexpr std::array<signed char, 4> DX = {0, 1, 1, 1};
+    static constexpr std::array<signed char, 4> DY = {1, 0, 1, -1};
+
+    // The index of the grid at `offset` from the middle of a pattern, offsets range in [-Radius, Radius] except 0
+    static constexpr unsigned int GetSlot(int offset) { return offset < 0 ? offset + Radius : offset + Radius - 1; }
+
+    using Pattern = Util::UIntByValue<(1 << PatternBits) - 1>;
+
+    // Swap the codes of the two players, so that a pattern can be seen from player 1
+    static constexpr uint32_t SwapPlayers(uint32_t pattern) {
+        uint32_t lowBits = 0;
+        for (int slot = 0; slot < 2 * Radius; ++slot)
+            lowBits |= uint32_t(1) << (2 * slot);
+        // The two bits of a code differ only for the codes of the players
+        return pattern ^ (((pattern ^ (pattern >> 1)) & lowBits) * 3);
+    }
+
+    // The threats a stone makes in the middle of a pattern, one bit for each `Threat` of player 0, followed by the ones
+    // of player 1
+    static inline const auto PatternTable = [] {
+        std::array<unsigned char, 1 << PatternBits> playerTable = {}, table;
+        for (uint32_t pattern = 0; pattern < playerTable.size(); ++pattern) {
+            const auto code = [&](int offset) { return (pattern >> (2 * GetSlot(offset))) & 3; };
+            int left = 0, right = 0;
+            while (left < Radius && code(-left - 1) == Player0)
+                ++left;
+            while (right < Radius && code(right + 1) == Player0)
+                ++right;
+            const auto length = left + right + 1;
+            if (length >= Renju)
+                playerTable[pattern] |= 1 << Five;
+            else if (length == Renju - 1 && left < Radius && right < Radius && code(-left - 1) == Empty &&
+                     code(right + 1) == Empty)
+                playerTable[pattern] |= 1 << OpenFour;
+        }
+        for (uint32_t pattern = 0; pattern < table.size(); ++pattern)
+            table[pattern] = playerTable[pattern] | playerTable[SwapPlayers(pattern)] << 2;
+        return table;
+    }();
+
+    // The patterns of each grid in each direction
+    std::array<std::array<Pattern, 4>, GridCount> m_Patterns;
+    // The threats of each grid in each direction, one byte for each direction, so that they can be combined at once
+    std::array<uint32_t, GridCount> m_PatternThreats;
+    // The threats of each grid in all directions, or none if the grid is occupied
+    std::array<unsigned char, GridCount> m_GridThreats;
+    BitBoard m_Occupied;
+    // The grids of each threat of each player
+    std::array<std::array<BitBoard, 2>, 2> m_Grids;
+
+    void SetPattern(PosType position, unsigned char dire, Pattern pattern) {
+        m_Patterns[position][dire] = pattern;
+        m_PatternThreats[position] = (m_PatternThreats[position] & ~(uint32_t(0xff) << (8 * dire))) |
+                                     uint32_t(PatternTable[pattern]) << (8 * dire);
+    }
+
+    void UpdateGrids(PosType position) {
+        unsigned char threats = 0;
+        if (!m_Occupied[position]) {
+            const auto patternThreats = m_PatternThreats[position] | m_PatternThreats[position] >> 16;
+            threats = static_cast<unsigned char>(patternThreats | patternThreats >> 8);
+        }
+        // Most stones do not change the threats of the grids around them
+        if (threats == m_GridThreats[position])
+            return;
+        m_GridThreats[position] = threats;
+        for (unsigned char player = 0; player < 2; ++player)
+            for (const auto threat : {Five, OpenFour})
+                if ((threats >> (player * 2 + threat)) & 1)
+                    m_Grids[threat][player].Set(position);
+                else
+                    m_Grids[threat][player].Reset(position);
+    }
+
+    // The patterns of an empty board, where only the grids off the board are set
+    static const Threats &GetEmpty() {
+        static const auto empty = [] {
+            Threats threats;
+            threats.m_PatternThreats = {};
+            threats.m_GridThreats = {};
+            threats.m_Occupied = {};
+            threats.m_Grids = {};
+            for (int row = 0; row < RowCount; ++row)
+                for (int col = 0; col < ColCount; ++col)
+                    for (unsigned char dire = 0; dire < 4; ++dire) {
+                        Pattern pattern = 0;
+                        for (int offset = -Radius; offset <= Radius; ++offset) {
+                            const auto x = row + offset * DX[dire], y = col + offset * DY[dire];
+                            if (offset != 0 && (x < 0 || x >= RowCount || y < 0 || y >= ColCount))
+                                pattern |= OffBoard << (2 * GetSlot(offset));
+                        }
+                        threats.SetPattern(row * ColCount + col, dire, pattern);
+                    }
+            return threats;
+        }();
+        return empty;
+    }
+
+public:
+    // Recompute the threats of the state
+    void Reset(const State &state) {
+        *this = GetEmpty();
+        for (unsigned char player = 0; player < 2; ++player)
+            for (auto position = state.BitBoards[player].FindNext(0); position < GridCount;
+                 position = state.BitBoards[player].FindNext(position + 1))
+                Update(position, player);
+    }
+
+    // Update the threats after `player` placed a stone on `position`
+    void Update(PosType position, unsigned char player) {
+        m_Occupied.Set(position);
+        UpdateGrids(position);
+        const int row = position / ColCount, col = position % ColCount;
+        for (unsigned char dire = 0; dire < 4; ++dire)
+            for (int offset = -Radius; offset <= Radius; ++offset) {
+                const auto x = row + offset * DX[dire], y = col + offset * DY[dire];
+                if (offset == 0 || x < 0 || x >= RowCount || y < 0 || y >= ColCount)
+                    continue;
+                // The patterns of an occupied grid are never used again, since a grid is only emptied by `Reset`
+                const PosType grid = x * ColCount + y;
+                if (m_Occupied[grid])
+                    continue;
+                // The stone is at `-offset` from the grid
+                SetPattern(grid, dire,
+                           m_Patterns[grid][dire] | (Player0 + player) << (2 * GetSlot(-offset)));
+                UpdateGrids(grid);
+            }
+    }
+
+    // The empty grids where a stone of `player` makes the threat
+    const BitBoard &GetGrids(Threat threat, unsigned char player) const {
+        return m_Grids[threat][player];
+    }
+};
+} // namespace m_n_k_game
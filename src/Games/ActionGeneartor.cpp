@@ -2,6 +2,7 @@
 #include "Gomoku/ActionGenerators/Default.hpp"
 #include "Gomoku/ActionGenerators/Neighbor.hpp"
 #include "TicTacToe/ActionGenerators/Default.hpp"
+#include <cassert>
 #include <unordered_map>
 
 template <typename T>
@@ -32,34 +33,53 @@ ActionGenerator::IteratorWrapper ActionGenerator::end(const Data &data, const Ga
     return IteratorWrapper(*this, data, state, nullptr);
 }
 
-std::vector<std::unique_ptr<Game::Action>> ActionGenerator::GetActionList(const Data &data,
-                                                                          const Game::State &state) const {
-    std::vector<std::unique_ptr<Game::Action>> actionList;
+unsigned int ActionGenerator::GetActionCount(const Data &data, const Game::State &state) const {
+    unsigned int count = 0;
+    std::for_each(begin(data, state), end(data, state), [&](const Game::Action &) { ++count; });
+    return count;
+}
+
+std::vector<Game::ActionValue> ActionGenerator::GetActionList(const Data &data, const Game::State &state) const {
+    std::vector<Game::ActionValue> actionList;
     std::for_each(begin(data, state), end(data, state),
-                  [&](const Game::Action &action) { actionList.push_back(action.Clone()); });
+                  [&](const Game::Action &action) { actionList.emplace_back(action); });
     return actionList;
 }
 
-std::unique_ptr<Game::Action> ActionGenerator::GetNthAction(const Data &data, const Game::State &state,
-                                                            unsigned int idx) const {
+Game::ActionValue ActionGenerator::GetNthAction(const Data &data, const Game::State &state, unsigned int idx) const {
     auto iter = begin(data, state);
     while (idx--)
         ++iter;
-    return iter->Clone();
+    return Game::ActionValue(*iter);
 }
 
-std::unique_ptr<Game::Action> ActionGenerator::GetRandomAction(const Data &data, const Game::State &state) const {
+Game::ActionValue ActionGenerator::GetRandomAction(const Data &data, const Game::State &state) const {
     unsigned int count = 0;
-    std::unique_ptr<Game::Action> chosenAction;
+    Game::ActionValue chosenAction;
     auto &engine = Util::GetRandomEngine();
     std::for_each(begin(data, state), end(data, state), [&](const Game::Action &action) {
         std::uniform_int_distribution<unsigned int> random(0, count++);
         if (random(engine) == 0)
-            chosenAction = action.Clone();
+            chosenAction = action;
     });
     return chosenAction;
 }
 
+const Game::Action &ActionGenerator::ChooseRandomAction(const Data &data, const Game::State &state,
+                                                       Iterator &iterator) const {
+    // Unlike `GetRandomAction`, only one random number is drawn, at the cost of counting the actions first
+    const auto count = GetActionCount(data, state);
+    assert(count > 0);
+    std::uniform_int_distribution<unsigned int> random(0, count - 1);
+    auto idx = random(Util::GetRandomEngine());
+    ResetIterator(data, state, iterator);
+    while (idx--) {
+        [[maybe_unused]] const auto isValid = NextIterator(data, state, iterator);
+        assert(isValid);
+    }
+    return GetActionFromIterator(data, state, iterator);
+}
+
 bool operator==(const ActionGenerator::IteratorWrapper &left, const ActionGenerator::IteratorWrapper &right) {
     assert(left.m_ActionGenerator == right.m_ActionGenerator);
     assert(left.m_ActionGeneratorData == right.m_ActionGeneratorData);
@@ -19,6 +19,12 @@ public:
         virtual bool Equal(const Data &) const { return true; }
     };
 
+    // The part of the data changed by `UpdateData`, saved so that the update can be undone together with the action,
+    // see `Game::UndoAction`
+    struct UndoData {
+        virtual ~UndoData() = default;
+    };
+
     struct Iterator {
         virtual ~Iterator() = default;
         virtual std::unique_ptr<Iterator> Clone() const = 0;
@@ -35,8 +41,17 @@ public:
 
     virtual std::unique_ptr<Data> CreateData(const Game::State &) const { return std::make_unique<Data>(); }
     virtual void UpdateData(Data &, const Game::State &, const Game::Action &) const {}
+    // Recompute the data in place for an unrelated state, the same as `CreateData` but without allocating
+    virtual void ResetData(Data &, const Game::State &) const {}
+    // Action generators whose updates can be undone return the buffer of `SaveUndoData`, the others return null.
+    // `SaveUndoData` is called right before `UpdateData`, and `UndoUpdateData` restores the data from what it saved
+    virtual std::unique_ptr<UndoData> CreateUndoData() const { return nullptr; }
+    virtual void SaveUndoData(const Data &, UndoData &) const {}
+    virtual void UndoUpdateData(Data &, const UndoData &) const {}
 
     virtual std::unique_ptr<Iterator> FirstIterator(const Data &data, const Game::State &state) const = 0;
+    // Rewind an existing iterator to the first action, the same as `FirstIterator` but without allocating
+    virtual void ResetIterator(const Data &data, const Game::State &state, Iterator &iterator) const = 0;
     virtual bool NextIterator(const Data &data, const Game::State &state, Iterator &iterator) const = 0;
     virtual const Game::Action &GetActionFromIterator(const Data &data, const Game::State &state,
                                                       const Iterator &iterator) const = 0;
@@ -45,10 +60,14 @@ public:
 
     // The base class provides default implementations of the following methods by using `FirstIterator`,
     // `NextIterator`, `GetActionFromIterator`, better implementations can be overridden by subclasses
-    virtual std::vector<std::unique_ptr<Game::Action>> GetActionList(const Data &data, const Game::State &state) const;
-    virtual std::unique_ptr<Game::Action> GetNthAction(const Data &data, const Game::State &state,
-                                                       unsigned int idx) const;
-    virtual std::unique_ptr<Game::Action> GetRandomAction(const Data &data, const Game::State &state) const;
+    virtual unsigned int GetActionCount(const Data &data, const Game::State &state) const;
+    virtual std::vector<Game::ActionValue> GetActionList(const Data &data, const Game::State &state) const;
+    virtual Game::ActionValue GetNthAction(const Data &data, const Game::State &state, unsigned int idx) const;
+    virtual Game::ActionValue GetRandomAction(const Data &data, const Game::State &state) const;
+    // Choose a random action without allocating, `iterator` is rewound and moved to the chosen action, and the returned
+    // action is valid until `iterator` is changed
+    virtual const Game::Action &ChooseRandomAction(const Data &data, const Game::State &state,
+                                                   Iterator &iterator) const;
 };
 
 class ActionGenerator::IteratorWrapper {
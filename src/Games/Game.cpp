@@ -3,6 +3,11 @@
 #include "TicTacToe/Game.hpp"
 #include <unordered_map>
 
+static_assert(sizeof(tic_tac_toe::Game::State) <= Game::MaxInlineStateSize &&
+              sizeof(gomoku::Game::State) <= Game::MaxInlineStateSize);
+static_assert(sizeof(tic_tac_toe::Game::Action) <= Game::MaxInlineActionSize &&
+              sizeof(gomoku::Game::Action) <= Game::MaxInlineActionSize);
+
 template <typename T>
 static std::unique_ptr<Game> CreateGame(const nlohmann::json &data) {
     return std::make_unique<T>(data);
@@ -1,41 +1,79 @@
 #pragma once
 
+#include "../Utilities/InlineValue.hpp"
+#include "../Utilities/InlineVector.hpp"
 #include "../Utilities/Utilities.hpp"
+#include <cstddef>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <cstdint>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 
-// TODO: Result: small vector optimization
-
 class Game : public Util::NonCopyableNonMoveable {
 public:
     struct State {
         virtual ~State() = default;
         virtual std::unique_ptr<State> Clone() const = 0;
+        // The size of the state, and a copy of it constructed at `memory`, used by `StateValue`
+        virtual std::size_t GetSize() const = 0;
+        virtual State *CloneAt(void *memory) const = 0;
+        // Overwrite this state with another state of the same game, used to reuse the memory of a state
+        virtual void CopyFrom(const State &state) = 0;
         virtual bool Equal(const State &state) const = 0;
+        // Equal states must have equal hashes, used to find transpositions
+        virtual uint64_t Hash() const = 0;
         virtual nlohmann::json GetJson() const = 0;
     };
 
     struct Action {
         virtual ~Action() = default;
         virtual std::unique_ptr<Action> Clone() const = 0;
+        // The size of the action, and a copy of it constructed at `memory`, used by `ActionValue`
+        virtual std::size_t GetSize() const = 0;
+        virtual Action *CloneAt(void *memory) const = 0;
         virtual bool Equal(const Action &action) const = 0;
         virtual nlohmann::json GetJson() const = 0;
     };
 
+    // States and actions passed around by value. The inline capacities fit the largest states and actions of the games
+    // registered in `Game.cpp`, which checks them, so only the states and actions of other games are on the heap
+    static constexpr std::size_t MaxInlineStateSize = 88;
+    static constexpr std::size_t MaxInlineActionSize = 16;
+    using StateValue = InlineValue<State, MaxInlineStateSize>;
+    using ActionValue = InlineValue<Action, MaxInlineActionSize>;
+
+    // The result of a finished game, the score of each player. It is held inline, so that finishing a game does not
+    // allocate, and no game may have more players than `MaxPlayerCount`
+    static constexpr std::size_t MaxPlayerCount = 2;
+    using Result = InlineVector<float, MaxPlayerCount>;
+
     static std::unique_ptr<Game> Create(const std::string &type, const nlohmann::json &data);
 
     virtual ~Game() = default;
     virtual std::string_view GetType() const = 0;
 
-    virtual std::unique_ptr<State> CreateDefaultState() const = 0;
-    virtual std::unique_ptr<State> CreateState(const nlohmann::json &data) const = 0;
-    virtual std::unique_ptr<Action> CreateAction(const nlohmann::json &data) const = 0;
+    virtual StateValue CreateDefaultState() const = 0;
+    virtual StateValue CreateState(const nlohmann::json &data) const = 0;
+    virtual ActionValue CreateAction(const nlohmann::json &data) const = 0;
+
+    // Actions may be numbered from 0 to `GetActionIndexCount() - 1` regardless of the state, so that statistics can be
+    // kept for each action, e.g. the all-moves-as-first statistics of RAVE. Games that do not number actions return 0
+    virtual unsigned int GetActionIndexCount() const { return 0; }
+    virtual unsigned int GetActionIndex(const Action &) const { return 0; }
 
     virtual unsigned char GetNextPlayer(const State &state) const = 0;
     virtual bool IsValidAction(const State &state, const Action &action) const = 0;
-    virtual std::optional<std::vector<float>> TakeAction(State &state, const Action &action) const = 0;
+    // Returns the result if the game is over
+    virtual std::optional<Result> TakeAction(State &state, const Action &action) const = 0;
+
+    // Games that return true from `CanUndo` implement `UndoAction`, which reverts the last `TakeAction` on the state,
+    // given the same action. A search can then walk one state up and down the tree instead of copying it for every node
+    virtual bool CanUndo() const { return false; }
+    virtual void UndoAction(State &, const Action &) const {
+        throw std::invalid_argument("The game does not support undoing actions");
+    }
 };
@@ -1,16 +1,20 @@
 #include "Player.hpp"
 #include "../../Games/ActionGenerator.hpp"
 #include "../../Games/Game.hpp"
+#include "../../Utilities/TripleBuffer.hpp"
+#include "UCB.hpp"
 #include <algorithm>
-#include <cmath>
-#include <future>
+#include <array>
+#include <chrono>
+#include <condition_variable>
 #include <limits>
 #include <numeric>
+#include <optional>
+#include <stdexcept>
 #include <thread>
-#include <typeinfo>
 
 namespace mcts {
-// There are 5 different node types:
+// There are 6 different node types:
 //   TerminalNode:
 //     The corresponding state is a terminal state.
 //   NewNode:
@@ -30,17 +34,38 @@ namespace mcts {
 //     anymore, but stores `NextPlayer`, which is used during backpropagation. When `PartiallyExpandedNode` is turned
 //     into `FullyExpandedNode`, all `NewNode`s in its child nodes should be turned into `UnexpandedNode` due to the
 //     release of the state in their parent state, so there's no `NewNode` in the child nodes of `FullyExpandedNode`.
+//   SharedNode:
+//     Only used when the transposition table is enabled. When a `NewNode` is turned into an `UnexpandedNode`, its state
+//     is looked up in the transposition table, and if the same state has been reached through another path, the child
+//     refers to the existing `SharedNode` instead, so the tree becomes a DAG where the subtree of a position and its
+//     statistics are shared by all paths leading to it. A `SharedNode` wraps the node of the position and counts its
+//     references, it is destroyed when the last parent is destroyed. The statistics of the edges (the arrays of the
+//     parents) are still separate for each parent, only the statistics below the position are shared.
 
-// The inheritance diagram of different node types:
-//                         [Node(abstract)]
-//                                |
-//         ------------------------------------------------
-//         |            |            |                    |
-//   [TerminalNode] [NewNode] [UnexpandedNode] [ExpandedNode(abstract)]
-//                                                        |
-//                                             ------------------------
-//                                             |                      |
-//                                  [PartiallyExpandedNode]  [FullyExpandedNode]
+// If `replay` is enabled, the nodes store no states at all. Each worker keeps a single `WorkingState`, takes the action
+// of every node it passes through on the way down, and undoes them all after copying the state for rollout, so that
+// expanding a node clones nothing. The expanded nodes then keep the `Action` leading to them, which they take over from
+// the `NewNode` they used to be, `PartiallyExpandedNode`s have no `State` or `ActionGeneratorData`, the children of
+// `FullyExpandedNode`s stay `NewNode`s, and `UnexpandedNode` is never created. A child whose action ends the game is
+// turned into a `TerminalNode` as soon as it is created, so the working state is never a terminal state.
+
+// Nodes carry no vtable, the concrete type is identified by the `Type` tag in the first byte. The statistics of a node
+// (`ScoreSum` and `RolloutCount`) are not stored in the node itself, but in its parent, as dense arrays next to the
+// child pointers, so selecting a child only scans contiguous memory instead of visiting every child. The statistics of
+// the root node are stored in the `Tree`. The layout of different node types:
+//                               [Node: Type]
+//                                     |
+//         -------------------------------------------------------------
+//         |                |                   |                      |
+//   [TerminalNode]     [NewNode]       [UnexpandedNode]     [ExpandedNode: NextPlayer, Lock,
+//     Result            Action         State, ActionGenerator  Children, ChildScoreSums,
+//                                      Data                    ChildRolloutCounts, ChildAMAF]
+//                                                                     |
+//                                                     --------------------------------
+//                                                     |                              |
+//                                         [PartiallyExpandedNode]          [FullyExpandedNode]
+//                                         State, ActionGeneratorData,
+//                                         ActionIterator
 
 // This is how it transitions between different node types
 //   [When `PartiallyExpandedNode` is visited]
@@ -59,7 +84,8 @@ namespace mcts {
 //     [FullyExpandedNode]
 
 // To offer an insight, here are the numbers of each node type, and the time spent on each step of the algorithm after
-// performing 100,000 iterations on Gomoku with neighbor action generator (range=1):
+// performing 100,000 iterations on Gomoku with neighbor action generator (range=1). The same numbers are reported live
+// by `QueryDetails` if `MCTS_INSTRUMENTATION` is defined, see `Instrumentation`:
 //   Node count:
 //     TerminalNode:               0
 //     NewNode:               65,877
@@ -71,357 +97,1261 @@ namespace mcts {
 //     Expand:            81ms
 //     Rollout:       10,346ms
 //     BackPropagate:     52ms
+// Since child statistics are stored in the parent, `Select` takes about half of the time shown above. The node storage
+// (not counting states, action generator data and child arrays) is about 50 bytes per node at the node counts above,
+// measured with `sizeof` on x86-64: 48 bytes for a `NewNode`, which holds its action inline in a 32-byte
+// `Game::ActionValue`, 24 for an `UnexpandedNode`, 80 for a `PartiallyExpandedNode`, and 56 for a `FullyExpandedNode`.
+
+// In tree parallelization, all workers search one shared tree. Statistics are atomic and are updated without locks: the
+// rollout counts are incremented while descending, so that a node being evaluated by one worker looks like a loss to
+// the others until its result is added to the score sums (virtual loss). The structure of the tree is guarded by a spin
+// lock in each expanded node (and one in the `Tree` for the root), which protects the `Children` of the node. `Select`
+// takes the locks hand over hand, so a worker only holds the lock of the parent of the node it is looking at, and the
+// node it selects is expanded while still holding the lock of its parent. Locks are always taken from top to bottom, so
+// there is no deadlock. Only `Select`, `Expand` and copying the state for rollout are done under the lock, while the
+// rollout, which takes more than 95% of the time, runs without any lock.
+
+// Nodes are never allocated by the global `operator new`. Each game tree owns a `MemoryPool`, and all its nodes are
+// allocated from that pool through `CreateNode`, so creating a node costs a few pointer operations, and the memory of
+// pruned subtrees is reused by new nodes instead of going back and forth to the system allocator.
+enum class Player::NodeType : uint8_t { Terminal, New, Unexpanded, PartiallyExpanded, FullyExpanded, Shared };
+static constexpr std::size_t NodeTypeCount = 6;
 
 struct Player::Node {
-    float Score;
-    uint32_t RolloutCount;
+    NodeType Type;
 
-    explicit Node(float score, uint32_t rolloutCount) : Score(score), RolloutCount(rolloutCount) {}
-    virtual ~Node() = default;
+    explicit Node(NodeType type) : Type(type) {}
 };
 
 struct Player::TerminalNode : public Node {
-    std::vector<float> Result;
+    Game::Result Result;
 
-    explicit TerminalNode(float score, uint32_t rolloutCount, std::vector<float> &&result)
-        : Node(score, rolloutCount), Result(std::move(result)) {}
+    explicit TerminalNode(const Game::Result &result) : Node(NodeType::Terminal), Result(result) {}
 };
 
 struct Player::NewNode : public Node {
-    std::unique_ptr<Game::Action> Action;
+    Game::ActionValue Action;
 
-    explicit NewNode(std::unique_ptr<Game::Action> &&action) : Node(0.0f, 0), Action(std::move(action)) {}
+    explicit NewNode(Game::ActionValue &&action) : Node(NodeType::New), Action(std::move(action)) {}
 };
 
 struct Player::UnexpandedNode : public Node {
     std::unique_ptr<Game::State> State;
     std::unique_ptr<ActionGenerator::Data> ActionGeneratorData;
 
-    explicit UnexpandedNode(float score, uint32_t rolloutCount, std::unique_ptr<Game::State> &&state,
+    explicit UnexpandedNode(std::unique_ptr<Game::State> &&state,
                             std::unique_ptr<ActionGenerator::Data> &&actionGeneratorData)
-        : Node(score, rolloutCount), State(std::move(state)), ActionGeneratorData(std::move(actionGeneratorData)) {}
+        : Node(NodeType::Unexpanded), State(std::move(state)), ActionGeneratorData(std::move(actionGeneratorData)) {}
+};
+
+// With RAVE, each iteration also updates the all-moves-as-first (AMAF) statistics of every child whose action the
+// player to move at the node takes at any later point of the iteration, in the tree or in the rollout. The action of a
+// child is identified by its index (see `Game::GetActionIndex`), which is looked up once when the node is expanded
+struct Player::AMAFStatistics {
+    uint32_t ActionCount;
+    std::unique_ptr<uint32_t[]> ActionIndices;
+    std::unique_ptr<std::atomic<float>[]> ScoreSums;
+    std::unique_ptr<std::atomic<uint32_t>[]> RolloutCounts;
+
+    explicit AMAFStatistics(uint32_t actionCount)
+        : ActionCount(actionCount), ActionIndices(std::make_unique<uint32_t[]>(actionCount)),
+          ScoreSums(std::make_unique<std::atomic<float>[]>(actionCount)),
+          RolloutCounts(std::make_unique<std::atomic<uint32_t>[]>(actionCount)) {}
 };
 
 struct Player::ExpandedNode : public Node {
-    std::vector<std::unique_ptr<Node>> Children;
+    uint8_t NextPlayer;
+    // Guards `Children` if the tree is shared. Only fully expanded nodes are locked, it fits in the padding
+    SpinLock Lock;
+    // The number of children created so far. Children are created one per visit, in the order of the action generator
+    uint32_t ChildCount = 0;
+    // The number of available actions, which is the capacity of the following arrays
+    uint32_t ActionCount;
+    std::unique_ptr<NodePtr[]> Children;
+    // Scores are summed instead of averaged, so that concurrent updates are plain additions
+    std::unique_ptr<std::atomic<float>[]> ChildScoreSums;
+    std::unique_ptr<std::atomic<uint32_t>[]> ChildRolloutCounts;
+    // Null if RAVE is disabled
+    std::unique_ptr<AMAFStatistics> ChildAMAF;
+    // The action that leads to the node, only kept if replaying, and null for the root. It's in a block of the pool of
+    // the tree, so that it costs a pointer instead of an inline `Game::ActionValue` in the nodes of the other modes,
+    // without a heap allocation
+    MemoryPool::Ptr<Game::ActionValue> Action;
 
-    explicit ExpandedNode(float score, uint32_t rolloutCount, std::vector<std::unique_ptr<Node>> &&children)
-        : Node(score, rolloutCount), Children(std::move(children)) {}
+    explicit ExpandedNode(NodeType type, uint8_t nextPlayer, uint32_t actionCount,
+                          std::unique_ptr<AMAFStatistics> &&childAMAF)
+        : Node(type), NextPlayer(nextPlayer), ActionCount(actionCount),
+          Children(std::make_unique<NodePtr[]>(actionCount)),
+          ChildScoreSums(std::make_unique<std::atomic<float>[]>(actionCount)),
+          ChildRolloutCounts(std::make_unique<std::atomic<uint32_t>[]>(actionCount)), ChildAMAF(std::move(childAMAF)) {}
+    // Take over the children of another expanded node, used when changing the type of the node
+    explicit ExpandedNode(NodeType type, ExpandedNode &&node)
+        : Node(type), NextPlayer(node.NextPlayer), ChildCount(node.ChildCount), ActionCount(node.ActionCount),
+          Children(std::move(node.Children)), ChildScoreSums(std::move(node.ChildScoreSums)),
+          ChildRolloutCounts(std::move(node.ChildRolloutCounts)), ChildAMAF(std::move(node.ChildAMAF)),
+          Action(std::move(node.Action)) {}
 };
+// The statistics are read by the UCB kernel as plain arrays
+static_assert(sizeof(std::atomic<float>) == sizeof(float) && std::atomic<float>::is_always_lock_free);
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free);
 
 struct Player::PartiallyExpandedNode : public ExpandedNode {
+    // Null if replaying
     std::unique_ptr<Game::State> State;
     std::unique_ptr<ActionGenerator::Data> ActionGeneratorData;
     std::unique_ptr<ActionGenerator::Iterator> ActionIterator;
 
-    explicit PartiallyExpandedNode(std::unique_ptr<Game::State> &&state,
+    explicit PartiallyExpandedNode(uint8_t nextPlayer, uint32_t actionCount, std::unique_ptr<Game::State> &&state,
                                    std::unique_ptr<ActionGenerator::Data> &&actionGeneratorData,
-                                   std::unique_ptr<ActionGenerator::Iterator> &&actionIterator)
-        : ExpandedNode(0.0f, 0, {}), State(std::move(state)), ActionGeneratorData(std::move(actionGeneratorData)),
+                                   std::unique_ptr<ActionGenerator::Iterator> &&actionIterator,
+                                   std::unique_ptr<AMAFStatistics> &&childAMAF)
+        : ExpandedNode(NodeType::PartiallyExpanded, nextPlayer, actionCount, std::move(childAMAF)),
+          State(std::move(state)), ActionGeneratorData(std::move(actionGeneratorData)),
           ActionIterator(std::move(actionIterator)) {}
-    explicit PartiallyExpandedNode(float score, uint32_t rolloutCount, std::unique_ptr<Game::State> &&state,
-                                   std::unique_ptr<ActionGenerator::Data> &&actionGeneratorData,
-                                   std::unique_ptr<ActionGenerator::Iterator> &&actionIterator)
-        : ExpandedNode(score, rolloutCount, {}), State(std::move(state)),
-          ActionGeneratorData(std::move(actionGeneratorData)), ActionIterator(std::move(actionIterator)) {}
 };
 
 struct Player::FullyExpandedNode : public ExpandedNode {
-    uint8_t NextPlayer;
+    explicit FullyExpandedNode(PartiallyExpandedNode &&node)
+        : ExpandedNode(NodeType::FullyExpanded, std::move(node)) {}
+};
 
-    explicit FullyExpandedNode(float score, uint32_t rolloutCount, std::vector<std::unique_ptr<Node>> &&children,
-                               uint8_t nextPlayer)
-        : ExpandedNode(score, rolloutCount, std::move(children)), NextPlayer(nextPlayer) {}
+struct Player::SharedNode : public Node {
+    // The wrapped node, which is never a `SharedNode`, `NewNode`, or `TerminalNode`
+    NodePtr Target;
+    uint64_t Hash;
+    TranspositionTable *Table;
+    // A `SharedNode` is held by multiple `NodePtr`s, one for each parent, and is destroyed by the deleter of the last
+    uint32_t RefCount = 1;
+    // The number of visits through any parent, used as the parent rollout count in the UCB formula of its children
+    uint32_t RolloutCount = 0;
+
+    explicit SharedNode(NodePtr &&node, uint64_t hash, TranspositionTable &table)
+        : Node(NodeType::Shared), Target(std::move(node)), Hash(hash), Table(&table) {}
 };
 
-enum class Player::Signal { StartThinking, StopThinking, GetBestAction, QueryDetails, Prune, Exit };
+// Fixed-size hash index from states to `SharedNode`s. Slots are grouped in buckets, a state may be stored in any slot
+// of its bucket, and when the bucket is full, the least visited node is replaced. A replaced node is not destroyed, it
+// is just no longer found by new paths, so the index only bounds the memory of the index itself. The index does not own
+// the nodes, a node removes itself from the index when it is destroyed.
+struct Player::TranspositionTable {
+    static constexpr std::size_t BucketSize = 4;
 
-struct Player::ThreadData {
-    std::thread Thread;
-    // From main thread to worker thread
-    std::promise<Signal> PromiseSignal;
-    std::future<Signal> FutureSignal;
-    // From worker thread to main thread
-    std::promise<void> PromiseDone;
-    std::future<void> FutureDone;
-    // Information reported by the worker thread
+    struct Slot {
+        uint64_t Hash = 0;
+        SharedNode *Node = nullptr;
+    };
+
+    std::vector<Slot> Slots;
+    TranspositionTableStatistics Statistics;
+
+    explicit TranspositionTable(std::size_t size) {
+        // Round up to a power of two, so that the bucket can be found with a mask
+        std::size_t capacity = BucketSize;
+        while (capacity < size)
+            capacity *= 2;
+        Slots.resize(capacity);
+        Statistics.Capacity = capacity;
+    }
+
+    Slot *GetBucket(uint64_t hash) { return &Slots[hash & (Slots.size() - 1) & ~(BucketSize - 1)]; }
+
+    SharedNode *Find(uint64_t hash) {
+        ++Statistics.Lookups;
+        const auto bucket = GetBucket(hash);
+        for (std::size_t idx = 0; idx < BucketSize; ++idx)
+            if (bucket[idx].Node && bucket[idx].Hash == hash) {
+                ++Statistics.Hits;
+                return bucket[idx].Node;
+            }
+        return nullptr;
+    }
+
+    void Insert(SharedNode &node) {
+        const auto bucket = GetBucket(node.Hash);
+        auto slot = bucket;
+        for (std::size_t idx = 0; idx < BucketSize; ++idx) {
+            if (!bucket[idx].Node) {
+                slot = &bucket[idx];
+                ++Statistics.Entries;
+                break;
+            }
+            if (bucket[idx].Node->RolloutCount < slot->Node->RolloutCount)
+                slot = &bucket[idx];
+        }
+        *slot = {node.Hash, &node};
+    }
+
+    void Erase(const SharedNode &node) {
+        const auto bucket = GetBucket(node.Hash);
+        for (std::size_t idx = 0; idx < BucketSize; ++idx)
+            if (bucket[idx].Node == &node) {
+                bucket[idx] = {};
+                --Statistics.Entries;
+                return;
+            }
+    }
+};
+
+// `NodeDeleter` only has the node, from which the pool is found by `MemoryPool::GetOwner`, so the node counts are kept
+// in the pool rather than in the `Tree`
+struct Player::NodePool : public MemoryPool {
+    // The number of nodes of each type, indexed by `NodeType`. Only counted if `MCTS_INSTRUMENTATION` is defined
+    std::array<std::atomic<int64_t>, NodeTypeCount> NodeCounts = {};
+
+    explicit NodePool(bool synchronized) : MemoryPool(synchronized) {}
+
+    void Count([[maybe_unused]] NodeType type, [[maybe_unused]] int64_t delta) {
+#ifdef MCTS_INSTRUMENTATION
+        NodeCounts[static_cast<std::size_t>(type)].fetch_add(delta, std::memory_order_relaxed);
+#endif
+    }
+};
+
+// The counters of the iterations run by one worker, which are only collected if `MCTS_INSTRUMENTATION` is defined. A
+// worker is the only writer of its counters, and the main thread reads them at any time, so they are atomic but never
+// updated with read-modify-write operations. Reading the clock 5 times per iteration costs about 0.1 us, which is
+// negligible compared to a rollout
+struct Player::Instrumentation {
+    enum Phase : uint8_t { Select, Expand, Rollout, BackPropagate, PhaseCount };
+
+    std::atomic<uint64_t> Iterations = 0;
+    // The depth of the node selected by each iteration, below the root
+    std::atomic<uint64_t> DepthSum = 0;
+    std::atomic<uint64_t> MaxDepth = 0;
+    std::array<std::atomic<uint64_t>, PhaseCount> PhaseNanoseconds = {};
+    std::chrono::steady_clock::time_point PhaseStart;
+
+    static void Add(std::atomic<uint64_t> &counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+#ifdef MCTS_INSTRUMENTATION
+    void StartIteration() { PhaseStart = std::chrono::steady_clock::now(); }
+
+    void EndPhase(Phase phase) {
+        const auto now = std::chrono::steady_clock::now();
+        Add(PhaseNanoseconds[phase], std::chrono::duration_cast<std::chrono::nanoseconds>(now - PhaseStart).count());
+        PhaseStart = now;
+    }
+
+    void EndIteration(std::size_t depth) {
+        EndPhase(BackPropagate);
+        Add(Iterations, 1);
+        Add(DepthSum, depth);
+        if (depth > MaxDepth.load(std::memory_order_relaxed))
+            MaxDepth.store(depth, std::memory_order_relaxed);
+    }
+#else
+    void StartIteration() {}
+    void EndPhase(Phase) {}
+    void EndIteration(std::size_t) {}
+#endif
+};
+
+struct Player::Tree {
+    // Declared before `Root`, so that the pool and the transposition table outlive all the nodes
+    NodePool Pool;
+    std::unique_ptr<TranspositionTable> Table;
+    NodePtr Root;
+    // The `RolloutCount` of the root node is used when traversing the tree, but the `ScoreSum` of the root node is not
+    // used, so we don't store score
+    std::atomic<uint32_t> RootRolloutCount = 0;
+    // Guards `Root` if the tree is shared
+    mutable SpinLock RootLock;
+    // The state and action generator data of the root node. `FullyExpandedNode`s do not store their states, so the
+    // states are rebuilt from the root when their subtrees are collapsed, or replayed from the root if replaying
+    Game::StateValue RootState;
+    std::unique_ptr<ActionGenerator::Data> RootActionGeneratorData;
+    // Incremented whenever the root state is replaced, so that the workers know when to copy it again
+    uint64_t RootVersion = 0;
+    // See `EvictionStatistics`, the skipped expansions are counted by all workers if the tree is shared
+    uint64_t Evictions = 0;
+    uint64_t EvictedNodes = 0;
+    std::atomic<uint64_t> SkippedExpansions = 0;
+    // The number of nodes proven by the solver. Once the root is proven, the index of the child that proves it, and the
+    // exact result
+    uint64_t ProvenNodes = 0;
+    std::optional<uint32_t> ProvenChild;
+    Game::Result ProvenResult;
+    ReuseStatistics Reuse;
+    // Subtrees discarded by `Prune`, `Solve`, and `Evict`, which are released a few nodes at a time by the thread that
+    // searches the tree, see `ReleaseNodes`. Guards `Discarded` if the tree is shared
+    std::vector<NodePtr> Discarded;
+    SpinLock DiscardedLock;
+    // Whether the pool is to be compacted once all discarded nodes are released
+    bool CompactPending = false;
+
+    explicit Tree(bool shared, unsigned int transpositionTableSize)
+        : Pool(shared),
+          Table(transpositionTableSize > 0 ? std::make_unique<TranspositionTable>(transpositionTableSize) : nullptr) {}
+    // Release the nodes iteratively, since a deep tree would overflow the stack if destroyed recursively
+    ~Tree() {
+        Discard(*this, std::move(Root));
+        ReleaseNodes(*this);
+    }
+};
+
+struct Player::WorkingState {
+    // Copies of the root state and action generator data of the tree, and the `RootVersion` they were copied at
+    Game::StateValue State;
+    std::unique_ptr<ActionGenerator::Data> ActionGeneratorData;
+    std::optional<uint64_t> RootVersion;
+    // Copies of the actions taken since the root, since the nodes holding them may be changed by other workers, and an
+    // action held inline moves with its node
+    std::vector<Game::ActionValue> Actions;
+    // What is needed to undo the update of the action generator data for each action taken. They are reused by all
+    // iterations, and only grow with the depth of the tree
+    std::vector<std::unique_ptr<ActionGenerator::UndoData>> UndoData;
+};
+
+void Player::NodeDeleter::operator()(Node *node) const {
+    const auto type = node->Type;
+    switch (type) {
+    case NodeType::Terminal:
+        static_cast<TerminalNode *>(node)->~TerminalNode();
+        break;
+    case NodeType::New:
+        static_cast<NewNode *>(node)->~NewNode();
+        break;
+    case NodeType::Unexpanded:
+        static_cast<UnexpandedNode *>(node)->~UnexpandedNode();
+        break;
+    case NodeType::PartiallyExpanded:
+        static_cast<PartiallyExpandedNode *>(node)->~PartiallyExpandedNode();
+        break;
+    case NodeType::FullyExpanded:
+        static_cast<FullyExpandedNode *>(node)->~FullyExpandedNode();
+        break;
+    case NodeType::Shared: {
+        const auto sharedNode = static_cast<SharedNode *>(node);
+        if (--sharedNode->RefCount > 0)
+            return;
+        sharedNode->Table->Erase(*sharedNode);
+        sharedNode->~SharedNode();
+        break;
+    }
+    }
+    static_cast<NodePool &>(MemoryPool::GetOwner(node)).Count(type, -1);
+    MemoryPool::Deallocate(node);
+}
+
+enum class Player::Signal : uint8_t { None, StartThinking, StopThinking, Prune, Exit };
+
+struct Player::Report {
     std::vector<unsigned int> ActionRolloutCount;
     std::vector<float> ActionScore;
-    unsigned int TotalRolloutCount;
+    // Whether each action is proven to lose by the solver, such actions are never chosen
+    std::vector<uint8_t> ActionProvenLoss;
+    unsigned int TotalRolloutCount = 0;
+    MemoryPool::Statistics MemoryStatistics;
+    std::array<int64_t, NodeTypeCount> NodeCounts = {};
+    EvictionStatistics Eviction;
+    TranspositionTableStatistics TranspositionStatistics;
+    ReuseStatistics Reuse;
+    uint64_t ProvenNodes = 0;
+    std::optional<uint32_t> ProvenChild;
+    Game::Result ProvenResult;
+};
 
-    ThreadData() : FutureSignal(PromiseSignal.get_future()), FutureDone(PromiseDone.get_future()) {}
+struct Player::ThreadData {
+    std::thread Thread;
+    // The signal sent by the main thread and not yet handled, `Signal::None` if there is none. While running
+    // iterations, the worker only checks it with a single atomic load between two iterations, and otherwise sleeps on
+    // `Condition`. The signal is written and cleared with `Mutex` held, so that neither side can miss a notification
+    std::atomic<Signal> PendingSignal = Signal::None;
+    // Set by the worker thread when the signal has been handled, guarded by `Mutex`
+    bool Done = false;
+    std::mutex Mutex;
+    // Notified in both directions, when a signal is sent and when it has been handled
+    std::condition_variable Condition;
+    // The statistics of the tree of the worker, published every `ReportPeriod` while thinking, and after each signal.
+    // The main thread reads the latest one without interrupting the worker
+    TripleBuffer<Report> Reports;
+    // Updated by the worker in every iteration, and read through atomics
+    Instrumentation Counters;
 };
 
-std::unique_ptr<Player::Node> &Player::Select(std::unique_ptr<Node> &root, std::stack<ExpandedNode *> &path) const {
-    assert(root);
+template <typename T, typename... TArgs>
+Player::NodePtr Player::CreateNode(NodePool &pool, TArgs &&... args) {
+    void *memory = pool.Allocate(sizeof(T));
+    try {
+        NodePtr node(new (memory) T(std::forward<TArgs>(args)...));
+        pool.Count(node->Type, 1);
+        return node;
+    } catch (...) {
+        MemoryPool::Deallocate(memory);
+        throw;
+    }
+}
+
+Player::NodePtr &Player::Resolve(NodePtr &node) {
+    return node->Type == NodeType::Shared ? static_cast<SharedNode &>(*node).Target : node;
+}
+
+const Player::NodePtr &Player::Resolve(const NodePtr &node) {
+    return node->Type == NodeType::Shared ? static_cast<const SharedNode &>(*node).Target : node;
+}
+
+// How often the sequential algorithm checks whether the best action is settled, in iterations, and the parallel
+// algorithm in time
+static constexpr unsigned int EarlyStopCheckInterval = 64;
+static constexpr auto EarlyStopCheckPeriod = std::chrono::milliseconds(10);
+// The interval at which the workers in root parallelization publish the statistics of their trees
+static constexpr auto ReportPeriod = std::chrono::milliseconds(1);
+
+// Whether the most visited child of the root is settled, that is, the second most visited one cannot catch up with it
+// even if all the remaining rollouts are given to it. Ties are broken in favor of the first child, the same as
+// `std::max_element` when choosing the best action, so a child before the best one needs one rollout less to catch up
+template <typename TIter>
+static bool IsSettled(TIter first, TIter last, double remainingRolloutCount) {
+    if (first == last)
+        return false;
+    const auto bestIter = std::max_element(first, last);
+    double secondCount = 0;
+    for (auto iter = first; iter != last; ++iter)
+        if (iter != bestIter)
+            secondCount = std::max<double>(secondCount, *iter + (iter < bestIter ? 1 : 0));
+    return secondCount + remainingRolloutCount <= *bestIter;
+}
+
+void Player::SyncWorkingState(WorkingState &workingState, const Tree &tree) {
+    assert(workingState.Actions.empty());
+    if (workingState.RootVersion == tree.RootVersion)
+        return;
+    workingState.State = *tree.RootState;
+    workingState.ActionGeneratorData = tree.RootActionGeneratorData->Clone();
+    workingState.RootVersion = tree.RootVersion;
+}
+
+const Game::Action &Player::GetReplayAction(const Node &node) {
+    if (node.Type == NodeType::New)
+        return *static_cast<const NewNode &>(node).Action;
+    assert(node.Type == NodeType::PartiallyExpanded || node.Type == NodeType::FullyExpanded);
+    return **static_cast<const ExpandedNode &>(node).Action;
+}
+
+std::optional<Game::Result> Player::TakeWorkingAction(WorkingState &workingState, const Game::Action &action) const {
+    auto &state = *workingState.State;
+    if (auto result = m_Game->TakeAction(state, action)) {
+        m_Game->UndoAction(state, action);
+        return result;
+    }
+    const auto depth = workingState.Actions.size();
+    if (workingState.UndoData.size() == depth)
+        workingState.UndoData.push_back(m_ActionGenerator->CreateUndoData());
+    m_ActionGenerator->SaveUndoData(*workingState.ActionGeneratorData, *workingState.UndoData[depth]);
+    m_ActionGenerator->UpdateData(*workingState.ActionGeneratorData, state, action);
+    workingState.Actions.emplace_back(action);
+    return std::nullopt;
+}
+
+void Player::UndoWorkingActions(WorkingState &workingState) const {
+    while (!workingState.Actions.empty()) {
+        const auto depth = workingState.Actions.size() - 1;
+        m_ActionGenerator->UndoUpdateData(*workingState.ActionGeneratorData, *workingState.UndoData[depth]);
+        m_Game->UndoAction(*workingState.State, *workingState.Actions[depth]);
+        workingState.Actions.pop_back();
+    }
+}
+
+Player::NodePtr &Player::Select(Tree &tree, std::vector<PathItem> &path, std::unique_lock<SpinLock> *lock,
+                                WorkingState *workingState) const {
     assert(path.empty());
-    auto node = &root;
-    while (typeid(**node) == typeid(FullyExpandedNode)) {
+    if (lock)
+        *lock = std::unique_lock(tree.RootLock);
+    assert(tree.Root);
+    auto node = &Resolve(tree.Root);
+    // The counts before the increments are used, which are the numbers of visits before this iteration
+    auto rolloutCount = tree.RootRolloutCount.fetch_add(1, std::memory_order_relaxed);
+    while ((*node)->Type == NodeType::FullyExpanded) {
         auto &fullExpNode = static_cast<FullyExpandedNode &>(**node);
-        path.push(&fullExpNode);
-        // Select the child node with the largest UCB
-        auto maxUCB = std::numeric_limits<double>::lowest();
-        std::unique_ptr<Node> *maxNode = nullptr;
-        for (auto &childNode : fullExpNode.Children) {
-            // Every child of the fully expanded nodes has been visited at least once
-            assert(childNode->RolloutCount > 0);
-            const auto ucb = childNode->Score + m_ExplorationFactor * std::sqrt(2 * std::log(fullExpNode.RolloutCount) /
-                                                                                childNode->RolloutCount);
-            if (ucb > maxUCB) {
-                maxUCB = ucb;
-                maxNode = &childNode;
-            }
+        // The new lock is taken before the old one is released, so that the node cannot be changed in between
+        if (lock)
+            *lock = std::unique_lock(fullExpNode.Lock);
+        // Select the child node with the largest UCB, every child of the fully expanded nodes has been visited at least
+        // once. See `UCB.hpp` for the vectorized kernel, which reads the statistics without atomic operations. If the
+        // tree is shared, a concurrent update may or may not be seen, just as with relaxed atomic loads
+        const auto scoreSums = reinterpret_cast<const float *>(fullExpNode.ChildScoreSums.get());
+        const auto rolloutCounts = reinterpret_cast<const uint32_t *>(fullExpNode.ChildRolloutCounts.get());
+        const auto amaf = fullExpNode.ChildAMAF.get();
+        auto maxIdx =
+            amaf ? ucb::SelectChildRAVE(
+                       scoreSums, rolloutCounts, reinterpret_cast<const float *>(amaf->ScoreSums.get()),
+                       reinterpret_cast<const uint32_t *>(amaf->RolloutCounts.get()), fullExpNode.ActionCount,
+                       rolloutCount, static_cast<float>(m_ExplorationFactor), static_cast<float>(m_RaveEquivalence))
+                 : ucb::SelectChild(scoreSums, rolloutCounts, fullExpNode.ActionCount, rolloutCount,
+                                    static_cast<float>(m_ExplorationFactor));
+        if (m_Solver && IsProvenLoss(fullExpNode, maxIdx))
+            maxIdx = SelectUnprovenChild(fullExpNode, rolloutCount, maxIdx);
+        auto &childNode = fullExpNode.Children[maxIdx];
+        path.push_back({&childNode, &fullExpNode.ChildScoreSums[maxIdx], amaf, maxIdx, fullExpNode.NextPlayer});
+        rolloutCount = fullExpNode.ChildRolloutCounts[maxIdx].fetch_add(1, std::memory_order_relaxed);
+        if (childNode->Type == NodeType::Shared) {
+            // The children of a shared node are chosen based on the visits through all of its parents
+            auto &sharedNode = static_cast<SharedNode &>(*childNode);
+            rolloutCount = sharedNode.RolloutCount++;
+            node = &sharedNode.Target;
+        } else
+            node = &childNode;
+        // The children whose actions end the game are already `TerminalNode`s
+        if (workingState && (*node)->Type != NodeType::Terminal) {
+            [[maybe_unused]] const auto result = TakeWorkingAction(*workingState, GetReplayAction(**node));
+            assert(!result);
         }
-        assert(maxNode && *maxNode);
-        node = maxNode;
     }
     assert(*node);
     return *node;
 }
 
-Player::Node &Player::Expand(std::unique_ptr<Player::Node> &node, std::stack<ExpandedNode *> &path) const {
-    assert(node && typeid(*node) != typeid(FullyExpandedNode) && typeid(*node) != typeid(NewNode));
-    if (typeid(*node) == typeid(TerminalNode))
-        return *node;
-    if (typeid(*node) == typeid(UnexpandedNode)) {
+uint32_t Player::SelectUnprovenChild(const ExpandedNode &node, uint32_t rolloutCount, uint32_t fallback) const {
+    const auto coef = static_cast<float>(m_ExplorationFactor) * ucb::GetParentTerm(rolloutCount);
+    const auto amaf = node.ChildAMAF.get();
+    auto maxValue = std::numeric_limits<float>::lowest();
+    auto maxIdx = fallback;
+    for (uint32_t idx = 0; idx < node.ActionCount; ++idx) {
+        if (IsProvenLoss(node, idx))
+            continue;
+        const auto scoreSum = node.ChildScoreSums[idx].load(std::memory_order_relaxed);
+        const auto count = node.ChildRolloutCounts[idx].load(std::memory_order_relaxed);
+        const auto value =
+            amaf ? ucb::GetUCBRAVE(scoreSum, count, amaf->ScoreSums[idx].load(std::memory_order_relaxed),
+                                   amaf->RolloutCounts[idx].load(std::memory_order_relaxed), coef,
+                                   static_cast<float>(m_RaveEquivalence))
+                 : ucb::GetUCB(scoreSum, count, coef);
+        if (value > maxValue) {
+            maxValue = value;
+            maxIdx = idx;
+        }
+    }
+    return maxIdx;
+}
+
+std::pair<const Player::Node &, const Player::ExpandedNode *>
+Player::Expand(NodePtr &node, std::vector<PathItem> &path, Tree &tree, WorkingState *workingState) const {
+    // `NewNode`s are only selected if replaying, since the children of `FullyExpandedNode`s stay `NewNode`s
+    assert(node && node->Type != NodeType::FullyExpanded && (node->Type != NodeType::New || workingState) &&
+           node->Type != NodeType::Shared);
+    auto &pool = tree.Pool;
+    if (node->Type == NodeType::Terminal)
+        return {*node, nullptr};
+    // If the tree is still full after eviction, or if it's shared and nothing is evicted, the node is rolled out from
+    // its own state without creating any node
+    if (IsFull(tree)) {
+        tree.SkippedExpansions.fetch_add(1, std::memory_order_relaxed);
+        return {*node, nullptr};
+    }
+    if (node->Type == NodeType::Unexpanded) {
         // Move state and action generator data from `UnexpandedNode` to the new `PartiallyExpandedNode`
         auto &unExpNode = static_cast<UnexpandedNode &>(*node);
+        const auto nextPlayer = m_Game->GetNextPlayer(*unExpNode.State);
+        const auto actionCount = m_ActionGenerator->GetActionCount(*unExpNode.ActionGeneratorData, *unExpNode.State);
         auto actionIterator = m_ActionGenerator->FirstIterator(*unExpNode.ActionGeneratorData, *unExpNode.State);
-        node = std::make_unique<PartiallyExpandedNode>(node->Score, node->RolloutCount, std::move(unExpNode.State),
-                                                       std::move(unExpNode.ActionGeneratorData),
-                                                       std::move(actionIterator));
+        auto childAMAF = CreateAMAFStatistics(*unExpNode.State, *unExpNode.ActionGeneratorData, actionCount);
+        node = CreateNode<PartiallyExpandedNode>(pool, nextPlayer, actionCount, std::move(unExpNode.State),
+                                                 std::move(unExpNode.ActionGeneratorData), std::move(actionIterator),
+                                                 std::move(childAMAF));
+    } else if (node->Type == NodeType::New) {
+        // The working state has been walked down to the node, and the node takes over the action from `NewNode`
+        const auto &state = *workingState->State;
+        const auto &actionGeneratorData = *workingState->ActionGeneratorData;
+        const auto nextPlayer = m_Game->GetNextPlayer(state);
+        const auto actionCount = m_ActionGenerator->GetActionCount(actionGeneratorData, state);
+        auto actionIterator = m_ActionGenerator->FirstIterator(actionGeneratorData, state);
+        auto childAMAF = CreateAMAFStatistics(state, actionGeneratorData, actionCount);
+        auto action = pool.New<Game::ActionValue>(std::move(static_cast<NewNode &>(*node).Action));
+        node = CreateNode<PartiallyExpandedNode>(pool, nextPlayer, actionCount, nullptr, nullptr,
+                                                 std::move(actionIterator), std::move(childAMAF));
+        static_cast<PartiallyExpandedNode &>(*node).Action = std::move(action);
     }
-    assert(typeid(*node) == typeid(PartiallyExpandedNode));
+    assert(node->Type == NodeType::PartiallyExpanded);
     // Expand the current node. Instead of expanding all child nodes at once, we create one child node per visit
     auto &partExpNode = static_cast<PartiallyExpandedNode &>(*node);
-    const auto &nextAction = m_ActionGenerator->GetActionFromIterator(*partExpNode.ActionGeneratorData,
-                                                                      *partExpNode.State, *partExpNode.ActionIterator);
-    std::unique_ptr<Node> newNode = std::make_unique<NewNode>(nextAction.Clone());
-    partExpNode.Children.push_back(std::move(newNode));
+    assert(partExpNode.ChildCount < partExpNode.ActionCount);
+    const auto &nodeState = workingState ? *workingState->State : *partExpNode.State;
+    const auto &nodeActionGeneratorData =
+        workingState ? *workingState->ActionGeneratorData : *partExpNode.ActionGeneratorData;
+    const auto &nextAction =
+        m_ActionGenerator->GetActionFromIterator(nodeActionGeneratorData, nodeState, *partExpNode.ActionIterator);
+    const auto childIdx = partExpNode.ChildCount++;
+    partExpNode.Children[childIdx] = CreateNode<NewNode>(pool, Game::ActionValue(nextAction));
     // If all children are expanded, turn this node into a `FullyExpandedNode`
-    if (!m_ActionGenerator->NextIterator(*partExpNode.ActionGeneratorData, *partExpNode.State,
-                                         *partExpNode.ActionIterator)) {
+    if (!m_ActionGenerator->NextIterator(nodeActionGeneratorData, nodeState, *partExpNode.ActionIterator)) {
+        assert(partExpNode.ChildCount == partExpNode.ActionCount);
         // Because the parent state is about to be freed (there is no `State` in `FullyExpandedNode`), all `NewNode`s of
         // the children should be turned into `UnexpandedNode`, that is, the children should store `State` instead of
-        // `Action`
-        for (auto &childNode : partExpNode.Children) {
-            assert(typeid(*childNode) == typeid(NewNode) || typeid(*childNode) == typeid(TerminalNode));
-            if (typeid(*childNode) != typeid(NewNode))
-                continue;
-            const auto &childNewNode = static_cast<const NewNode &>(*childNode);
-            // Clone the state and action generator data from the parent, and take action on the cloned ones
-            auto state = partExpNode.State->Clone();
-            auto result = m_Game->TakeAction(*state, *childNewNode.Action);
-            if (result) {
-                childNode =
-                    std::make_unique<TerminalNode>(childNode->Score, childNode->RolloutCount, std::move(*result));
-                continue;
+        // `Action`. If replaying, the children stay `NewNode`s, since their states are replayed anyway
+        if (!workingState)
+            for (uint32_t idx = 0; idx < partExpNode.ChildCount; ++idx) {
+                auto &childNode = partExpNode.Children[idx];
+                assert(childNode->Type == NodeType::New || childNode->Type == NodeType::Terminal);
+                if (childNode->Type != NodeType::New)
+                    continue;
+                const auto &childNewNode = static_cast<const NewNode &>(*childNode);
+                // Clone the state and action generator data from the parent, and take action on the cloned ones
+                auto state = partExpNode.State->Clone();
+                auto result = m_Game->TakeAction(*state, *childNewNode.Action);
+                if (result) {
+                    childNode = CreateNode<TerminalNode>(pool, *result);
+                    continue;
+                }
+                // Look up the state in the transposition table, and refer to the existing node if the state is found.
+                // The selected child is rolled out from its own state right after, so it always gets its own node
+                uint64_t hash = 0;
+                if (tree.Table && idx != childIdx) {
+                    hash = state->Hash();
+                    if (const auto sharedNode = tree.Table->Find(hash)) {
+                        ++sharedNode->RefCount;
+                        childNode = NodePtr(sharedNode);
+                        continue;
+                    }
+                }
+                auto actionGeneratorData = partExpNode.ActionGeneratorData->Clone();
+                m_ActionGenerator->UpdateData(*actionGeneratorData, *state, *childNewNode.Action);
+                childNode = CreateNode<UnexpandedNode>(pool, std::move(state), std::move(actionGeneratorData));
+                if (tree.Table && idx != childIdx) {
+                    childNode = CreateNode<SharedNode>(pool, std::move(childNode), hash, *tree.Table);
+                    tree.Table->Insert(static_cast<SharedNode &>(*childNode));
+                }
             }
-            auto actionGeneratorData = partExpNode.ActionGeneratorData->Clone();
-            m_ActionGenerator->UpdateData(*actionGeneratorData, *state, *childNewNode.Action);
-            childNode = std::make_unique<UnexpandedNode>(childNewNode.Score, childNewNode.RolloutCount,
-                                                         std::move(state), std::move(actionGeneratorData));
-        }
         // Turn the current node into `FullyExpandedNode`
-        const auto nextPlayer = m_Game->GetNextPlayer(*partExpNode.State);
-        node = std::make_unique<FullyExpandedNode>(partExpNode.Score, partExpNode.RolloutCount,
-                                                   std::move(partExpNode.Children), nextPlayer);
+        node = CreateNode<FullyExpandedNode>(pool, std::move(partExpNode));
     }
-    assert(dynamic_cast<ExpandedNode *>(node.get()));
     auto &expNode = static_cast<ExpandedNode &>(*node);
-    path.push(&expNode);
+    path.push_back({&expNode.Children[childIdx], &expNode.ChildScoreSums[childIdx], expNode.ChildAMAF.get(), childIdx,
+                    expNode.NextPlayer});
+    // The count is incremented before the lock is released, so a fully expanded node never has an unvisited child
+    expNode.ChildRolloutCounts[childIdx].fetch_add(1, std::memory_order_relaxed);
+    if (workingState) {
+        auto &childNode = expNode.Children[childIdx];
+        if (auto result = TakeWorkingAction(*workingState, GetReplayAction(*childNode)))
+            childNode = CreateNode<TerminalNode>(pool, *result);
+    }
     // Select the newly created node, it may be `NewNode`, `TerminalNode`, or `UnexpandedNode`
-    assert(!expNode.Children.empty());
-    return *expNode.Children.back();
+    return {*expNode.Children[childIdx], &expNode};
+}
+
+std::unique_ptr<Player::AMAFStatistics> Player::CreateAMAFStatistics(const Game::State &state,
+                                                                     const ActionGenerator::Data &actionGeneratorData,
+                                                                     uint32_t actionCount) const {
+    if (m_RaveEquivalence <= 0)
+        return nullptr;
+    auto amaf = std::make_unique<AMAFStatistics>(actionCount);
+    // The children are created in the order of the action generator
+    uint32_t idx = 0;
+    for (auto iter = m_ActionGenerator->begin(actionGeneratorData, state),
+              end = m_ActionGenerator->end(actionGeneratorData, state);
+         iter != end; ++iter)
+        amaf->ActionIndices[idx++] = m_Game->GetActionIndex(*iter);
+    assert(idx == actionCount);
+    return amaf;
 }
 
-std::vector<float> Player::Rollout(const Node &node, const std::stack<ExpandedNode *> &path) const {
-    if (typeid(node) == typeid(TerminalNode))
+std::optional<Game::Result> Player::GetRolloutStart(const Node &node, const ExpandedNode *parent, Game::State &state,
+                                                    const WorkingState *workingState) const {
+    if (node.Type == NodeType::Terminal)
         return static_cast<const TerminalNode &>(node).Result;
-    assert(node.RolloutCount == 0);
-    // Get the state to perform rollout, if it's `NewNode`, the state is calculated from the action
-    std::unique_ptr<Game::State> state;
-    if (typeid(node) == typeid(NewNode)) {
-        assert(!path.empty());
-        assert(typeid(*path.top()) == typeid(PartiallyExpandedNode));
-        const auto &lastPartExpNode = static_cast<const PartiallyExpandedNode &>(*path.top());
+    if (workingState) {
+        state.CopyFrom(*workingState->State);
+        return std::nullopt;
+    }
+    // If it's `NewNode`, the state is calculated from the action
+    if (node.Type == NodeType::New) {
+        assert(parent && parent->Type == NodeType::PartiallyExpanded);
+        const auto &partExpNode = static_cast<const PartiallyExpandedNode &>(*parent);
         const auto &newNode = static_cast<const NewNode &>(node);
-        state = lastPartExpNode.State->Clone();
-        auto result = m_Game->TakeAction(*state, *newNode.Action);
-        if (result)
-            return std::move(*result);
-    } else { // if (typeid(node) == typeid(UnexpandedNode))
-        assert(typeid(node) == typeid(UnexpandedNode));
-        const auto &unExpNode = static_cast<const UnexpandedNode &>(node);
-        state = unExpNode.State->Clone();
-    }
-    // Rollout
-    const auto player = Player::Create(m_RolloutPolicyType, *m_Game, *state, m_RolloutPolicyData);
-    std::optional<std::vector<float>> result;
-    player->StartThinking();
-    while (true) {
-        const auto action = player->GetBestAction(std::nullopt);
-        result = m_Game->TakeAction(*state, *action);
-        if (result)
-            break;
-        player->Update(*action);
+        state.CopyFrom(*partExpNode.State);
+        return m_Game->TakeAction(state, *newNode.Action);
     }
-    player->StopThinking();
-    return std::move(*result);
+    // `PartiallyExpandedNode` is only rolled out if the tree is full
+    if (node.Type == NodeType::PartiallyExpanded) {
+        state.CopyFrom(*static_cast<const PartiallyExpandedNode &>(node).State);
+        return std::nullopt;
+    }
+    assert(node.Type == NodeType::Unexpanded);
+    const auto &unExpNode = static_cast<const UnexpandedNode &>(node);
+    state.CopyFrom(*unExpNode.State);
+    return std::nullopt;
 }
 
-void Player::BackPropagate(Node *node, std::stack<ExpandedNode *> &path, const std::vector<float> &result) const {
+// `std::atomic<float>::fetch_add` is not available until C++20
+static void AtomicAdd(std::atomic<float> &value, float addend) {
+    auto expected = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(expected, expected + addend, std::memory_order_relaxed))
+        ;
+}
+
+float Player::GetScore(const Game::Result &result, uint8_t player) const {
+    const auto &coef = m_GoalMatrix[player];
+    return std::inner_product(result.cbegin(), result.cend(), coef.cbegin(), 0.0f);
+}
+
+bool Player::IsProvenLoss(const ExpandedNode &node, uint32_t childIdx) const {
+    const auto &childNode = node.Children[childIdx];
+    return m_Solver && childNode && childNode->Type == NodeType::Terminal &&
+           GetScore(static_cast<const TerminalNode &>(*childNode).Result, node.NextPlayer) <=
+               m_MinScores[node.NextPlayer];
+}
+
+void Player::BackPropagate(std::vector<PathItem> &path, const Game::Result &result,
+                           const std::vector<PlayedAction> *rolloutActions, std::vector<uint8_t> &takenActions) const {
     // Calculate the incremental score for each player
-    std::vector<float> score;
-    score.reserve(m_GoalMatrix.size());
-    for (const auto &coef : m_GoalMatrix)
-        score.push_back(std::inner_product(result.cbegin(), result.cend(), coef.cbegin(), 0.0f));
-    // Update each node on the path
-    while (!path.empty()) {
-        // Get the next player
-        unsigned char nextPlayer;
-        if (typeid(*path.top()) == typeid(FullyExpandedNode)) {
-            const auto &fullExpNode = static_cast<const FullyExpandedNode &>(*path.top());
-            nextPlayer = fullExpNode.NextPlayer;
-        } else { // if (typeid(*path.top()) == typeid(PartiallyExpandedNode))
-            assert(typeid(*path.top()) == typeid(PartiallyExpandedNode));
-            const auto &partExpNode = static_cast<const PartiallyExpandedNode &>(*path.top());
-            nextPlayer = m_Game->GetNextPlayer(*partExpNode.State);
+    Game::Result score;
+    for (uint8_t player = 0; player < m_GoalMatrix.size(); ++player)
+        score.push_back(GetScore(result, player));
+    // Add the score to each child on the path, from the perspective of the player who chose it. The rollout counts have
+    // been incremented by `Select` and `Expand`
+    for (const auto &item : path)
+        AtomicAdd(*item.ScoreSum, score[item.Player]);
+    if (m_RaveEquivalence > 0) {
+        // Whether each player has taken each action, indexed by `player * actionIndexCount + actionIndex`. The path is
+        // walked from the bottom up, so when a node is reached, only the actions taken from that node on are marked
+        const auto actionIndexCount = m_Game->GetActionIndexCount();
+        takenActions.assign(score.size() * actionIndexCount, false);
+        if (rolloutActions)
+            for (const auto [actionIndex, player] : *rolloutActions)
+                takenActions[player * actionIndexCount + actionIndex] = true;
+        for (auto iter = path.crbegin(); iter != path.crend(); ++iter) {
+            const auto &amaf = *iter->AMAF;
+            const auto taken = takenActions.data() + iter->Player * actionIndexCount;
+            taken[amaf.ActionIndices[iter->ChildIndex]] = true;
+            // Children that are not created yet are updated as well, so they start with AMAF statistics
+            for (uint32_t idx = 0; idx < amaf.ActionCount; ++idx)
+                if (taken[amaf.ActionIndices[idx]]) {
+                    amaf.RolloutCounts[idx].fetch_add(1, std::memory_order_relaxed);
+                    AtomicAdd(amaf.ScoreSums[idx], score[iter->Player]);
+                }
+        }
+    }
+}
+
+void Player::Solve(Tree &tree, const std::vector<PathItem> &path) const {
+    for (auto idx = path.size(); idx-- > 0;) {
+        const auto &item = path[idx];
+        if ((*item.Child)->Type != NodeType::Terminal)
+            return;
+        auto &parentSlot = idx > 0 ? *path[idx - 1].Child : tree.Root;
+        auto &parent = static_cast<ExpandedNode &>(*Resolve(parentSlot));
+        const auto player = parent.NextPlayer;
+        const auto getChildScore = [&](uint32_t childIdx) {
+            return GetScore(static_cast<const TerminalNode &>(*parent.Children[childIdx]).Result, player);
+        };
+        // The average score of a proven child is its exact score, no matter what the rollouts before the proof said
+        const auto childScore = getChildScore(item.ChildIndex);
+        parent.ChildScoreSums[item.ChildIndex].store(
+            childScore * parent.ChildRolloutCounts[item.ChildIndex].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+        // The parent is proven if the player to move wins by taking the child, or if all children are proven, in which
+        // case the player to move takes the best one
+        std::optional<uint32_t> provenChild;
+        if (childScore >= m_MaxScores[player])
+            provenChild = item.ChildIndex;
+        else if (parent.Type == NodeType::FullyExpanded) {
+            auto bestScore = std::numeric_limits<float>::lowest();
+            for (uint32_t childIdx = 0; childIdx < parent.ActionCount; ++childIdx) {
+                if (parent.Children[childIdx]->Type != NodeType::Terminal)
+                    return;
+                if (const auto score = getChildScore(childIdx); score > bestScore) {
+                    bestScore = score;
+                    provenChild = childIdx;
+                }
+            }
+        }
+        if (!provenChild)
+            return;
+        ++tree.ProvenNodes;
+        // The result is copied, since the node holding it is about to be released
+        auto result = static_cast<const TerminalNode &>(*parent.Children[*provenChild]).Result;
+        if (idx == 0) {
+            tree.ProvenChild = provenChild;
+            tree.ProvenResult = result;
+            return;
+        }
+        Discard(tree, std::move(parentSlot));
+        parentSlot = CreateNode<TerminalNode>(tree.Pool, result);
+    }
+}
+
+void Player::ResetRoot(Tree &tree) const {
+    // The old tree is released by the next search, see `ReleaseNodes`
+    Discard(tree, std::move(tree.Root));
+    tree.RootState = *m_State;
+    tree.RootActionGeneratorData = m_ActionGeneratorData->Clone();
+    ++tree.RootVersion;
+    const auto nextPlayer = m_Game->GetNextPlayer(*m_State);
+    const auto actionCount = m_ActionGenerator->GetActionCount(*m_ActionGeneratorData, *m_State);
+    auto actionIterator = m_ActionGenerator->FirstIterator(*m_ActionGeneratorData, *m_State);
+    auto childAMAF = CreateAMAFStatistics(*m_State, *m_ActionGeneratorData, actionCount);
+    // If replaying, the root state is the one the workers copy into their working states
+    tree.Root = CreateNode<PartiallyExpandedNode>(
+        tree.Pool, nextPlayer, actionCount, m_Replay ? nullptr : m_State->Clone(),
+        m_Replay ? nullptr : m_ActionGeneratorData->Clone(), std::move(actionIterator), std::move(childAMAF));
+    tree.RootRolloutCount = 0;
+    tree.ProvenChild.reset();
+}
+
+void Player::Discard(Tree &tree, NodePtr &&node) {
+    if (!node)
+        return;
+    const std::scoped_lock lock(tree.DiscardedLock);
+    tree.Discarded.push_back(std::move(node));
+}
+
+void Player::ReleaseNodes(Tree &tree, std::size_t maxCount) {
+    // Discarded nodes are not reachable from the root, so they can be released while other workers search the tree
+    const std::unique_lock lock(tree.DiscardedLock, std::try_to_lock);
+    if (!lock)
+        return;
+    for (std::size_t count = 0; count < maxCount && !tree.Discarded.empty(); ++count) {
+        const auto node = std::move(tree.Discarded.back());
+        tree.Discarded.pop_back();
+        if (node->Type == NodeType::PartiallyExpanded || node->Type == NodeType::FullyExpanded) {
+            auto &expNode = static_cast<ExpandedNode &>(*node);
+            for (uint32_t idx = 0; idx < expNode.ChildCount; ++idx)
+                if (expNode.Children[idx])
+                    tree.Discarded.push_back(std::move(expNode.Children[idx]));
+        } else if (node->Type == NodeType::Shared) {
+            // The wrapped node is only released with the last reference to the `SharedNode`
+            auto &sharedNode = static_cast<SharedNode &>(*node);
+            if (sharedNode.RefCount == 1)
+                tree.Discarded.push_back(std::move(sharedNode.Target));
         }
-        // Update the score
-        node->Score = (node->Score * node->RolloutCount + score[nextPlayer]) / (node->RolloutCount + 1);
-        ++node->RolloutCount;
-        node = path.top();
-        path.pop();
     }
-    // The `RolloutCount` of the root node is used when traversing the tree, but the `Score` of the root node is not
-    // used, so we don't update score
-    ++node->RolloutCount;
+    // The chunks left empty are returned in bulk once the discarded subtrees are gone
+    if (tree.Discarded.empty() && tree.CompactPending) {
+        tree.Pool.Compact();
+        tree.CompactPending = false;
+    }
+}
+
+Player::EvictionStatistics Player::GetEvictionStatistics(const Tree &tree) {
+    return {tree.Evictions, tree.EvictedNodes, tree.SkippedExpansions.load(std::memory_order_relaxed)};
+}
+
+bool Player::IsFull(const Tree &tree) const {
+    return m_MaxNodes > 0 && tree.Pool.GetStatistics().BlocksInUse >= m_MaxNodes;
+}
+
+void Player::Evict(Tree &tree) const {
+    // The nodes waiting to be released are counted as in use, so they are released first
+    ReleaseNodes(tree);
+    if (!IsFull(tree))
+        return;
+    // Collapse down to three quarters of the limit, so that the cost of a pass is shared by many iterations
+    const auto nodeCount = tree.Pool.GetStatistics().BlocksInUse;
+    const auto targetNodeCount = m_MaxNodes / 4 * 3;
+    if (nodeCount <= targetNodeCount)
+        return;
+    auto &root = *Resolve(tree.Root);
+    if (root.Type != NodeType::FullyExpanded)
+        return;
+    // Find the rollout count up to which the subtrees are collapsed, from the least visited ones. Nested subtrees are
+    // counted more than once, so fewer nodes may be released than planned, in which case eviction runs again later
+    std::vector<std::pair<uint32_t, std::size_t>> subtrees;
+    CountSubtree(root, subtrees);
+    if (subtrees.empty())
+        return;
+    std::sort(subtrees.begin(), subtrees.end());
+    uint32_t maxRolloutCount = 0;
+    std::size_t plannedNodeCount = 0;
+    for (const auto &[rolloutCount, size] : subtrees) {
+        maxRolloutCount = rolloutCount;
+        plannedNodeCount += size;
+        if (plannedNodeCount >= nodeCount - targetNodeCount)
+            break;
+    }
+    CollapseSubtrees(static_cast<FullyExpandedNode &>(root), m_Replay ? nullptr : tree.RootState.Get(),
+                     m_Replay ? nullptr : tree.RootActionGeneratorData.get(), maxRolloutCount, tree);
+    ReleaseNodes(tree);
+    tree.EvictedNodes += nodeCount - tree.Pool.GetStatistics().BlocksInUse;
 }
 
-std::unique_ptr<Player::Node> Player::CreateRootNode() const {
-    auto state = m_State->Clone();
-    auto actionGeneratorData = m_ActionGeneratorData->Clone();
-    auto actionIterator = m_ActionGenerator->FirstIterator(*actionGeneratorData, *state);
-    return std::make_unique<PartiallyExpandedNode>(std::move(state), std::move(actionGeneratorData),
-                                                   std::move(actionIterator));
+std::size_t Player::CountSubtree(const Node &node, std::vector<std::pair<uint32_t, std::size_t>> &subtrees) {
+    if (node.Type != NodeType::PartiallyExpanded && node.Type != NodeType::FullyExpanded)
+        return 1;
+    const auto &expNode = static_cast<const ExpandedNode &>(node);
+    std::size_t size = 1;
+    for (uint32_t idx = 0; idx < expNode.ChildCount; ++idx) {
+        const auto &childNode = *Resolve(expNode.Children[idx]);
+        const auto childSize = CountSubtree(childNode, subtrees);
+        if (childNode.Type == NodeType::PartiallyExpanded || childNode.Type == NodeType::FullyExpanded)
+            subtrees.emplace_back(expNode.ChildRolloutCounts[idx], childSize);
+        size += childSize;
+    }
+    return size;
+}
+
+void Player::CollapseSubtrees(ExpandedNode &node, const Game::State *state,
+                              const ActionGenerator::Data *actionGeneratorData, uint32_t maxRolloutCount,
+                              Tree &tree) const {
+    // The children of `PartiallyExpandedNode`s are never expanded
+    if (node.Type != NodeType::FullyExpanded)
+        return;
+    for (uint32_t idx = 0; idx < node.ChildCount; ++idx) {
+        auto &childNode = Resolve(node.Children[idx]);
+        if (m_Replay) {
+            if (childNode->Type != NodeType::PartiallyExpanded && childNode->Type != NodeType::FullyExpanded)
+                continue;
+            if (node.ChildRolloutCounts[idx] > maxRolloutCount) {
+                CollapseSubtrees(static_cast<ExpandedNode &>(*childNode), nullptr, nullptr, maxRolloutCount, tree);
+                continue;
+            }
+            // The node is collapsed back into the `NewNode` it was, whose state is replayed from the root
+            auto newNode = CreateNode<NewNode>(tree.Pool, std::move(*static_cast<ExpandedNode &>(*childNode).Action));
+            Discard(tree, std::move(childNode));
+            childNode = std::move(newNode);
+            ++tree.Evictions;
+        } else if (childNode->Type == NodeType::PartiallyExpanded) {
+            if (node.ChildRolloutCounts[idx] > maxRolloutCount)
+                continue;
+            // The state is still stored in `PartiallyExpandedNode`, it's taken over by the new `UnexpandedNode`
+            auto &partExpNode = static_cast<PartiallyExpandedNode &>(*childNode);
+            auto unExpNode = CreateNode<UnexpandedNode>(tree.Pool, std::move(partExpNode.State),
+                                                        std::move(partExpNode.ActionGeneratorData));
+            Discard(tree, std::move(childNode));
+            childNode = std::move(unExpNode);
+            ++tree.Evictions;
+        } else if (childNode->Type == NodeType::FullyExpanded) {
+            // Children are created in the order of the action generator, so the state of the child can be rebuilt
+            const auto action = m_ActionGenerator->GetNthAction(*actionGeneratorData, *state, idx);
+            auto childState = state->Clone();
+            m_Game->TakeAction(*childState, *action);
+            auto childActionGeneratorData = actionGeneratorData->Clone();
+            m_ActionGenerator->UpdateData(*childActionGeneratorData, *childState, *action);
+            if (node.ChildRolloutCounts[idx] > maxRolloutCount) {
+                CollapseSubtrees(static_cast<FullyExpandedNode &>(*childNode), childState.get(),
+                                 childActionGeneratorData.get(), maxRolloutCount, tree);
+                continue;
+            }
+            Discard(tree, std::move(childNode));
+            childNode =
+                CreateNode<UnexpandedNode>(tree.Pool, std::move(childState), std::move(childActionGeneratorData));
+            ++tree.Evictions;
+        }
+    }
+}
+
+// The number of discarded nodes released before each iteration, several times the number of nodes an iteration creates,
+// so that the discarded subtrees are gone after a small part of the next search
+static constexpr std::size_t ReleaseBatchSize = 16;
+
+void Player::RunSingleIteration(Tree &tree, std::vector<PathItem> &path, Rollout &rollout,
+                                std::vector<uint8_t> &takenActions, Instrumentation &instrumentation,
+                                WorkingState *workingState) const {
+    if (!tree.Discarded.empty())
+        ReleaseNodes(tree, ReleaseBatchSize);
+    if (IsFull(tree))
+        Evict(tree);
+    if (workingState)
+        SyncWorkingState(*workingState, tree);
+    instrumentation.StartIteration();
+    auto &selectedNode = Select(tree, path, nullptr, workingState);
+    instrumentation.EndPhase(Instrumentation::Select);
+    const auto [expandedNode, parent] = Expand(selectedNode, path, tree, workingState);
+    auto result = GetRolloutStart(expandedNode, parent, rollout.GetState(), workingState);
+    if (workingState)
+        UndoWorkingActions(*workingState);
+    // A `NewNode` whose action ends the game is turned into a `TerminalNode` right away, so that the solver can see it
+    if (m_Solver && result && expandedNode.Type == NodeType::New)
+        *path.back().Child = CreateNode<TerminalNode>(tree.Pool, *result);
+    instrumentation.EndPhase(Instrumentation::Expand);
+    const std::vector<PlayedAction> *rolloutActions = nullptr;
+    if (!result) {
+        result = rollout.RunAverage(m_RolloutsPerLeaf);
+        rolloutActions = &rollout.GetPlayedActions();
+    }
+    instrumentation.EndPhase(Instrumentation::Rollout);
+    BackPropagate(path, *result, rolloutActions, takenActions);
+    if (m_Solver)
+        Solve(tree, path);
+    instrumentation.EndIteration(path.size());
+    path.clear();
 }
 
-void Player::RunSingleIteration(std::unique_ptr<Node> &root, std::stack<ExpandedNode *> &path) const {
-    auto &selectedNode = Select(root, path);
-    auto &expandedNode = Expand(selectedNode, path);
-    const auto result = Rollout(expandedNode, path);
-    BackPropagate(&expandedNode, path, result);
+void Player::RunSingleIterationShared(Tree &tree, std::vector<PathItem> &path, Rollout &rollout,
+                                      std::vector<uint8_t> &takenActions, Instrumentation &instrumentation,
+                                      WorkingState *workingState) const {
+    // Subtrees are only discarded while the workers are paused, and one worker at a time releases them
+    ReleaseNodes(tree, ReleaseBatchSize);
+    if (workingState)
+        SyncWorkingState(*workingState, tree);
+    instrumentation.StartIteration();
+    std::unique_lock<SpinLock> lock;
+    auto &selectedNode = Select(tree, path, &lock, workingState);
+    instrumentation.EndPhase(Instrumentation::Select);
+    const auto [expandedNode, parent] = Expand(selectedNode, path, tree, workingState);
+    // The nodes may be changed by other workers once the lock is released, so the state is copied before that
+    auto result = GetRolloutStart(expandedNode, parent, rollout.GetState(), workingState);
+    lock.unlock();
+    if (workingState)
+        UndoWorkingActions(*workingState);
+    instrumentation.EndPhase(Instrumentation::Expand);
+    const std::vector<PlayedAction> *rolloutActions = nullptr;
+    if (!result) {
+        result = rollout.RunAverage(m_RolloutsPerLeaf);
+        rolloutActions = &rollout.GetPlayedActions();
+    }
+    instrumentation.EndPhase(Instrumentation::Rollout);
+    BackPropagate(path, *result, rolloutActions, takenActions);
+    instrumentation.EndIteration(path.size());
+    path.clear();
 }
 
-std::unique_ptr<Game::Action> Player::ChooseBestActionSequential(const Node &root) const {
-    if (typeid(root) != typeid(FullyExpandedNode)) {
+Game::ActionValue Player::ChooseBestActionSequential(const Tree &tree) const {
+    if (tree.ProvenChild)
+        return m_ActionGenerator->GetNthAction(*m_ActionGeneratorData, *m_State, *tree.ProvenChild);
+    const auto &root = Resolve(tree.Root);
+    if (root->Type != NodeType::FullyExpanded) {
         // If the root node is not `FullyExpandedNode`, not all actions are evaluated, so we return the first action as
         // a fallback strategy, the same for `ReportData` and `Prune` below
         // TODO: Need a warning message
-        const auto &firstAction = *m_ActionGenerator->begin(*m_ActionGeneratorData, *m_State);
-        return firstAction.Clone();
-    }
-    const auto &fullExpNode = static_cast<const FullyExpandedNode &>(root);
-    assert(fullExpNode.Children.size() > 0);
-    // Get the index of the action with the most rollouts
-    unsigned int maxIdx = 0, maxCount = 0;
-    for (unsigned int idx = 0; idx < fullExpNode.Children.size(); ++idx) {
-        const auto count = fullExpNode.Children[idx]->RolloutCount;
+        // The iterator owns the action, so the action is copied before the iterator is destroyed
+        return Game::ActionValue(*m_ActionGenerator->begin(*m_ActionGeneratorData, *m_State));
+    }
+    const auto &fullExpNode = static_cast<const FullyExpandedNode &>(*root);
+    assert(fullExpNode.ActionCount > 0);
+    // Get the index of the action with the most rollouts, the actions proven to lose are never chosen. Not all of them
+    // are proven to lose, otherwise the root would be proven
+    uint32_t maxIdx = 0;
+    uint32_t maxCount = 0;
+    for (uint32_t idx = 0; idx < fullExpNode.ActionCount; ++idx) {
+        const uint32_t count = IsProvenLoss(fullExpNode, idx) ? 0 : fullExpNode.ChildRolloutCounts[idx].load();
         if (count > maxCount) {
-            maxCount = count;
             maxIdx = idx;
+            maxCount = count;
         }
     }
     return m_ActionGenerator->GetNthAction(*m_ActionGeneratorData, *m_State, maxIdx);
 }
 
-void Player::ReportData(ThreadData &data, const Node &root, bool includeScore) const {
-    if (typeid(root) != typeid(FullyExpandedNode)) {
+void Player::ReportData(Report &data, const Tree &tree) const {
+    // The root node may be replaced by a worker if the tree is shared, the statistics are atomic and can be read anyway
+    const std::scoped_lock lock(tree.RootLock);
+    data.ProvenChild = tree.ProvenChild;
+    data.ProvenNodes = tree.ProvenNodes;
+    data.ProvenResult = tree.ProvenResult;
+    data.MemoryStatistics = tree.Pool.GetStatistics();
+    for (std::size_t type = 0; type < NodeTypeCount; ++type)
+        data.NodeCounts[type] = tree.Pool.NodeCounts[type].load(std::memory_order_relaxed);
+    data.Eviction = GetEvictionStatistics(tree);
+    data.Reuse = tree.Reuse;
+    if (tree.Table)
+        data.TranspositionStatistics = tree.Table->Statistics;
+    const auto &root = Resolve(tree.Root);
+    if (root->Type != NodeType::FullyExpanded) {
         data.ActionRolloutCount.clear();
-        if (includeScore) {
-            data.ActionScore.clear();
-            data.TotalRolloutCount = 0;
-        }
+        data.ActionScore.clear();
+        data.ActionProvenLoss.clear();
+        data.TotalRolloutCount = 0;
         return;
     }
     // Action rollout count
-    const auto &fullExpNode = static_cast<const FullyExpandedNode &>(root);
-    data.ActionRolloutCount.resize(fullExpNode.Children.size());
-    for (unsigned int idx = 0; idx < fullExpNode.Children.size(); ++idx)
-        data.ActionRolloutCount[idx] = fullExpNode.Children[idx]->RolloutCount;
-    // Action score and total rollout count
-    if (includeScore) {
-        data.ActionScore.resize(fullExpNode.Children.size());
-        for (unsigned int idx = 0; idx < fullExpNode.Children.size(); ++idx)
-            data.ActionScore[idx] = fullExpNode.Children[idx]->Score;
-        data.TotalRolloutCount = root.RolloutCount;
-    }
-}
-
-void Player::Prune(std::unique_ptr<Node> &root) const {
-    if (typeid(*root) != typeid(FullyExpandedNode)) {
-        root = CreateRootNode();
-        return;
+    const auto &fullExpNode = static_cast<const FullyExpandedNode &>(*root);
+    data.ActionRolloutCount.assign(fullExpNode.ChildRolloutCounts.get(),
+                                   fullExpNode.ChildRolloutCounts.get() + fullExpNode.ActionCount);
+    // Action score, proven losses and total rollout count. The score of a proven child is its exact score, see `Solve`
+    data.ActionScore.resize(fullExpNode.ActionCount);
+    data.ActionProvenLoss.resize(fullExpNode.ActionCount);
+    for (uint32_t idx = 0; idx < fullExpNode.ActionCount; ++idx) {
+        const auto count = data.ActionRolloutCount[idx];
+        data.ActionScore[idx] = count == 0 ? 0.0f : fullExpNode.ChildScoreSums[idx] / count;
+        data.ActionProvenLoss[idx] = IsProvenLoss(fullExpNode, idx);
     }
-    auto &fullExpNode = static_cast<FullyExpandedNode &>(*root);
+    data.TotalRolloutCount = tree.RootRolloutCount;
+}
+
+void Player::PublishReport(ThreadData &data, const Tree &tree) const {
+    ReportData(data.Reports.GetBack(), tree);
+    data.Reports.Publish();
+}
+
+void Player::Prune(Tree &tree) const {
     // If `m_PruneActionIndex` is equal to `m_ActionList.size()`, the action taken is not found in `m_ActionList`, it
     // means that the opponent took an action that we did not consider, the entire existing game tree is to be freed
-    assert(m_PruneActionIndex <= fullExpNode.Children.size());
-    if (m_PruneActionIndex == fullExpNode.Children.size())
-        root = CreateRootNode();
-    else
-        root = std::move(fullExpNode.Children[m_PruneActionIndex]);
-}
-
-std::unique_ptr<Game::Action> Player::ChooseBestActionParallel() {
-    SendSignal(Signal::GetBestAction);
-    // Calculate the action with the most visit count
-    unsigned int maxIdx = 0, maxCount = 0;
-    for (unsigned int idx = 0; idx < m_ActionList.size(); ++idx) {
-        // Count the visit count of all threads for the action
-        unsigned int count = 0;
-        for (const auto &data : m_ThreadList)
-            if (data->ActionRolloutCount.size() > 0) {
-                assert(data->ActionRolloutCount.size() == m_ActionList.size());
-                count += data->ActionRolloutCount[idx];
+    auto &root = Resolve(tree.Root);
+    NodePtr child;
+    uint32_t childRolloutCount = 0;
+    if (root->Type == NodeType::FullyExpanded &&
+        m_PruneActionIndex < static_cast<const FullyExpandedNode &>(*root).ActionCount) {
+        auto &fullExpNode = static_cast<FullyExpandedNode &>(*root);
+        childRolloutCount = fullExpNode.ChildRolloutCounts[m_PruneActionIndex].load();
+        child = std::move(fullExpNode.Children[m_PruneActionIndex]);
+    } else if (root->Type == NodeType::PartiallyExpanded && m_PruneAction) {
+        // The child of the action is a `NewNode` if it's expanded, which becomes an `UnexpandedNode` of the new state,
+        // or stays a `NewNode` if replaying
+        auto &partExpNode = static_cast<PartiallyExpandedNode &>(*root);
+        for (uint32_t idx = 0; idx < partExpNode.ChildCount; ++idx) {
+            auto &childNode = partExpNode.Children[idx];
+            if (childNode->Type == NodeType::New &&
+                static_cast<const NewNode &>(*childNode).Action->Equal(*m_PruneAction)) {
+                childRolloutCount = partExpNode.ChildRolloutCounts[idx].load();
+                if (m_Replay)
+                    child = std::move(childNode);
+                else
+                    child = CreateNode<UnexpandedNode>(tree.Pool, m_State->Clone(), m_ActionGeneratorData->Clone());
+                break;
             }
-        if (count > maxCount) {
-            maxIdx = idx;
-            maxCount = count;
         }
     }
+    if (m_PruneAction)
+        ++tree.Reuse.Prunes;
+    // A node proven by the solver has lost its subtree, so the search starts over from the state
+    if (child && !(m_Solver && child->Type == NodeType::Terminal)) {
+        tree.RootRolloutCount = childRolloutCount;
+        Discard(tree, std::move(tree.Root));
+        tree.Root = std::move(child);
+        tree.RootState = *m_State;
+        tree.RootActionGeneratorData = m_ActionGeneratorData->Clone();
+        ++tree.RootVersion;
+        tree.ProvenChild.reset();
+        ++tree.Reuse.ReusedPrunes;
+        tree.Reuse.ReusedRollouts += childRolloutCount;
+    } else
+        ResetRoot(tree);
+    // The rest of the old tree is released by the next search, rather than while the caller waits
+    tree.CompactPending = true;
+}
+
+std::vector<const Player::Report *> Player::CollectReports() {
+    // Neither the shared tree nor the published reports of the workers require interrupting the workers. If no worker
+    // has been created yet, there is nothing searched to report
+    if (m_ParallelMode == ParallelMode::Tree) {
+        ReportData(*m_SharedTreeReport, *m_Tree);
+        return {m_SharedTreeReport.get()};
+    }
+    std::vector<const Report *> reports;
+    for (const auto &data : m_ThreadList)
+        reports.push_back(&data->Reports.Read());
+    return reports;
+}
+
+std::vector<unsigned int> Player::SumActionRolloutCounts(const std::vector<const Report *> &reports) const {
+    std::vector<unsigned int> counts(m_ActionList.size(), 0);
+    std::vector<uint8_t> provenLoss(m_ActionList.size(), false);
+    for (const auto data : reports)
+        if (data->ActionRolloutCount.size() > 0) {
+            assert(data->ActionRolloutCount.size() == m_ActionList.size());
+            for (unsigned int idx = 0; idx < m_ActionList.size(); ++idx) {
+                counts[idx] += data->ActionRolloutCount[idx];
+                provenLoss[idx] |= data->ActionProvenLoss[idx];
+            }
+        }
+    // An action proven to lose by one worker loses no matter how often the other workers have visited it
+    for (unsigned int idx = 0; idx < m_ActionList.size(); ++idx)
+        if (provenLoss[idx])
+            counts[idx] = 0;
+    return counts;
+}
+
+std::optional<uint32_t> Player::FindProvenAction(const std::vector<const Report *> &reports) {
+    for (const auto data : reports)
+        if (data->ProvenChild)
+            return data->ProvenChild;
+    return std::nullopt;
+}
+
+void Player::WaitParallel(std::chrono::duration<double> maxThinkTime) {
+    if (!m_EarlyStop && !m_Solver) {
+        std::this_thread::sleep_for(maxThinkTime);
+        return;
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto deadline = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(maxThinkTime);
+    const auto sum = [](const std::vector<unsigned int> &counts) {
+        return std::accumulate(counts.cbegin(), counts.cend(), 0.0);
+    };
+    const auto startRolloutCount = sum(SumActionRolloutCounts(CollectReports()));
+    while (true) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return;
+        std::this_thread::sleep_for(
+            std::min<std::chrono::steady_clock::duration>(EarlyStopCheckPeriod, deadline - now));
+        const auto reports = CollectReports();
+        if (FindProvenAction(reports))
+            return;
+        if (!m_EarlyStop)
+            continue;
+        // The rollouts that can still be run are estimated from the speed so far, which is unknown until the workers
+        // have run some
+        const auto counts = SumActionRolloutCounts(reports);
+        if (sum(counts) <= startRolloutCount)
+            continue;
+        const auto elapsed = std::chrono::steady_clock::now() - startTime;
+        const auto remaining = std::max(deadline - std::chrono::steady_clock::now(), elapsed.zero());
+        const auto remainingRolloutCount = (sum(counts) - startRolloutCount) * remaining / elapsed;
+        if (IsSettled(counts.cbegin(), counts.cend(), remainingRolloutCount))
+            return;
+    }
+}
+
+Game::ActionValue Player::ChooseBestActionParallel() {
+    const auto reports = CollectReports();
+    if (const auto provenIdx = FindProvenAction(reports))
+        return m_ActionGenerator->GetNthAction(*m_ActionGeneratorData, *m_State, *provenIdx);
+    // Calculate the action with the most visit count of all threads
+    const auto counts = SumActionRolloutCounts(reports);
+    const auto maxIdx = std::max_element(counts.cbegin(), counts.cend()) - counts.cbegin();
     return m_ActionGenerator->GetNthAction(*m_ActionGeneratorData, *m_State, maxIdx);
 }
 
 void Player::ThreadMain(ThreadData *data) {
-    auto root = CreateRootNode();
-    std::stack<ExpandedNode *> path;
+    // In tree parallelization, the shared tree is reported and pruned by the main thread, so the workers only respond
+    // to the thinking and exit signals
+    const auto shared = m_ParallelMode == ParallelMode::Tree;
+    std::optional<Tree> ownTree;
+    if (!shared) {
+        ownTree.emplace(false, m_TranspositionTableSize);
+        ResetRoot(*ownTree);
+    }
+    auto &tree = shared ? *m_Tree : *ownTree;
+    std::vector<PathItem> path;
+    std::vector<uint8_t> takenActions;
+    std::optional<WorkingState> workingState;
+    if (m_Replay)
+        workingState.emplace();
+    const auto workingStatePtr = workingState ? &*workingState : nullptr;
+    const auto rollout = Rollout::Create(m_RolloutPolicyType, *m_Game, m_RolloutPolicyData, m_RolloutsPerLeaf);
+    if (m_RaveEquivalence > 0)
+        rollout->RecordActions();
     bool working = false;
+    auto lastReportTime = std::chrono::steady_clock::now();
     while (true) {
-        // Since `std::future` lacks the `is_ready` function, we have to use `wait_until(...) != ready` to check if
-        // there is a signal sent, see https://stackoverflow.com/questions/10890242/get-the-status-of-a-stdfuture for
-        // details
-        if (working &&
-            data->FutureSignal.wait_until(std::chrono::steady_clock::time_point::min()) != std::future_status::ready) {
-            RunSingleIteration(root, path);
+        // A worker whose root is proven has nothing left to search, and waits for the next signal
+        if (working && !tree.ProvenChild && data->PendingSignal.load(std::memory_order_acquire) == Signal::None) {
+            if (shared)
+                RunSingleIterationShared(tree, path, *rollout, takenActions, data->Counters, workingStatePtr);
+            else {
+                RunSingleIteration(tree, path, *rollout, takenActions, data->Counters, workingStatePtr);
+                // Reading the clock takes a few nanoseconds, which is negligible compared to an iteration. The proof
+                // of the root is published at once, since the worker stops searching after it
+                const auto now = std::chrono::steady_clock::now();
+                if (now - lastReportTime >= ReportPeriod || tree.ProvenChild) {
+                    PublishReport(*data, tree);
+                    lastReportTime = now;
+                }
+            }
             continue;
         }
-        const auto signal = data->FutureSignal.get();
-        // `std::promise` can only be used once, create another one after use
-        data->PromiseSignal = {};
-        data->FutureSignal = data->PromiseSignal.get_future();
+        std::unique_lock lock(data->Mutex);
+        data->Condition.wait(lock, [&] { return data->PendingSignal.load(std::memory_order_relaxed) != Signal::None; });
+        const auto signal = data->PendingSignal.load(std::memory_order_relaxed);
+        // The main thread is blocked until `Done` is set, so the tree and the report can be accessed with the lock held
         if (signal == Signal::StartThinking)
             working = true;
         else if (signal == Signal::StopThinking)
             working = false;
-        else if (signal == Signal::GetBestAction)
-            ReportData(*data, *root, false);
-        else if (signal == Signal::QueryDetails)
-            ReportData(*data, *root, true);
         else if (signal == Signal::Prune)
-            Prune(root);
-        data->PromiseDone.set_value();
+            Prune(tree);
+        // The report is brought up to date before replying, so that it is of the new root after pruning, and includes
+        // all iterations after thinking is stopped
+        if (!shared && signal != Signal::Exit) {
+            PublishReport(*data, tree);
+            lastReportTime = std::chrono::steady_clock::now();
+        }
+        data->PendingSignal.store(Signal::None, std::memory_order_relaxed);
+        data->Done = true;
+        lock.unlock();
+        data->Condition.notify_all();
         if (signal == Signal::Exit)
             return;
     }
@@ -434,13 +1364,18 @@ void Player::SendSignal(Signal signal) {
             data->Thread = std::thread(&Player::ThreadMain, this, data.get());
             m_ThreadList.push_back(std::move(data));
         }
-    for (const auto &data : m_ThreadList)
-        data->PromiseSignal.set_value(signal);
+    // All workers are signaled before waiting for any of them, so they handle the signal at the same time
+    for (const auto &data : m_ThreadList) {
+        {
+            const std::scoped_lock lock(data->Mutex);
+            data->Done = false;
+            data->PendingSignal.store(signal, std::memory_order_release);
+        }
+        data->Condition.notify_all();
+    }
     for (const auto &data : m_ThreadList) {
-        data->FutureDone.wait();
-        // `std::promise` can only be used once, create another one after use
-        data->PromiseDone = {};
-        data->FutureDone = data->PromiseDone.get_future();
+        std::unique_lock lock(data->Mutex);
+        data->Condition.wait(lock, [&] { return data->Done; });
     }
 }
 
@@ -451,6 +1386,43 @@ Player::Player(const Game &game, const Game::State &state, const nlohmann::json
     m_RolloutPolicyType = rolloutPlayerJson["type"];
     m_RolloutPolicyData = rolloutPlayerJson["data"];
     m_Parallel = data["parallel"];
+    if (data.contains("transpositionTableSize"))
+        m_TranspositionTableSize = data["transpositionTableSize"];
+    if (data.contains("earlyStop"))
+        m_EarlyStop = data["earlyStop"];
+    if (data.contains("maxNodes"))
+        m_MaxNodes = data["maxNodes"];
+    if (data.contains("rolloutsPerLeaf"))
+        m_RolloutsPerLeaf = data["rolloutsPerLeaf"];
+    if (data.contains("raveEquivalence"))
+        m_RaveEquivalence = data["raveEquivalence"];
+    if (data.contains("solver"))
+        m_Solver = data["solver"];
+    if (data.contains("replay"))
+        m_Replay = data["replay"];
+    // The scores of all players are computed into a `Game::Result`
+    if (m_GoalMatrix.size() > Game::MaxPlayerCount)
+        throw std::invalid_argument("The goal matrix has more rows than the players of any game");
+    for (const auto &coef : m_GoalMatrix) {
+        m_MaxScores.push_back(std::accumulate(coef.cbegin(), coef.cend(), 0.0f,
+                                              [](float sum, double value) { return sum + std::max(value, 0.0); }));
+        m_MinScores.push_back(std::accumulate(coef.cbegin(), coef.cend(), 0.0f,
+                                              [](float sum, double value) { return sum + std::min(value, 0.0); }));
+    }
+    if (m_RaveEquivalence > 0) {
+        if (m_Game->GetActionIndexCount() == 0)
+            throw std::invalid_argument("RAVE is not supported by the game, whose actions are not numbered");
+        if (m_RolloutsPerLeaf > 1)
+            throw std::invalid_argument("RAVE is not supported with more than one rollout per leaf");
+    }
+    if (m_Replay) {
+        if (!m_Game->CanUndo() || !m_ActionGenerator->CreateUndoData())
+            throw std::invalid_argument("Replay is not supported by the game or the action generator, which cannot "
+                                        "undo actions");
+        // The nodes are reached through more than one path in a transposition table, but only one action leads to each
+        if (m_TranspositionTableSize > 0)
+            throw std::invalid_argument("Transposition table is not supported with replay");
+    }
     if (m_Parallel) {
         m_Workers = data["workers"];
         if (m_Workers == 0)
@@ -459,10 +1431,29 @@ Player::Player(const Game &game, const Game::State &state, const nlohmann::json
             // `hardware_concurrency` may return zero
             // TODO: Need a warning message
             m_Workers = 1;
+        if (data.contains("parallelMode") && data["parallelMode"] == "tree") {
+            if (m_TranspositionTableSize > 0)
+                throw std::invalid_argument("Transposition table is not supported in tree parallelization");
+            if (m_Solver)
+                throw std::invalid_argument("The solver is not supported in tree parallelization");
+            m_ParallelMode = ParallelMode::Tree;
+            m_Tree = std::make_unique<Tree>(true, 0);
+            ResetRoot(*m_Tree);
+            m_SharedTreeReport = std::make_unique<Report>();
+        }
         // To avoid leaking `this` during construction, worker threads are created the first time `SendSignal` is called
-        m_ActionList = m_ActionGenerator->GetActionList(*m_ActionGeneratorData, *m_State);
-    } else
+    } else {
         m_Iterations = data["iterations"];
+        m_Tree = std::make_unique<Tree>(false, m_TranspositionTableSize);
+        ResetRoot(*m_Tree);
+        m_Rollout = Rollout::Create(m_RolloutPolicyType, *m_Game, m_RolloutPolicyData, m_RolloutsPerLeaf);
+        if (m_RaveEquivalence > 0)
+            m_Rollout->RecordActions();
+        m_Instrumentation = std::make_unique<Instrumentation>();
+        if (m_Replay)
+            m_WorkingState = std::make_unique<WorkingState>();
+    }
+    m_ActionList = m_ActionGenerator->GetActionList(*m_ActionGeneratorData, *m_State);
 }
 
 Player::~Player() {
@@ -474,51 +1465,239 @@ Player::~Player() {
 }
 
 void Player::StartThinking() {
-    if (m_Parallel)
+    if (m_Parallel) {
         SendSignal(Signal::StartThinking);
+        m_Thinking = true;
+    }
 }
 
 void Player::StopThinking() {
-    if (m_Parallel)
+    if (m_Parallel) {
         SendSignal(Signal::StopThinking);
+        m_Thinking = false;
+    }
 }
 
-std::unique_ptr<Game::Action> Player::GetBestAction(std::optional<std::chrono::duration<double>> maxThinkTime) {
+Game::ActionValue Player::GetBestAction(std::optional<std::chrono::duration<double>> maxThinkTime) {
+    // There is nothing to decide if only one action is available
+    if (m_EarlyStop && m_ActionList.size() == 1)
+        return m_ActionList.front();
     if (m_Parallel) {
         if (maxThinkTime)
-            std::this_thread::sleep_for(*maxThinkTime);
+            WaitParallel(*maxThinkTime);
         return ChooseBestActionParallel();
     }
-    auto root = CreateRootNode();
-    std::stack<ExpandedNode *> path;
-    for (unsigned int iter = 0; iter < m_Iterations; ++iter)
-        RunSingleIteration(root, path);
-    return ChooseBestActionSequential(*root);
+    // The tree is kept from the previous moves, so the iterations are added to the subtree of the current state
+    m_InheritedRolloutCount = m_Tree->RootRolloutCount;
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<PathItem> path;
+    std::vector<uint8_t> takenActions;
+    for (unsigned int iter = 0; iter < m_Iterations && !m_Tree->ProvenChild; ++iter) {
+        // Reading the clock takes a few nanoseconds, which is negligible compared to an iteration
+        if (maxThinkTime || (m_EarlyStop && iter % EarlyStopCheckInterval == 0)) {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+            if (maxThinkTime && elapsed >= *maxThinkTime)
+                break;
+            if (m_EarlyStop && iter % EarlyStopCheckInterval == 0) {
+                // The iterations that can still be run, limited by the deadline at the speed so far. The speed is
+                // unknown before the first iterations, and the inherited tree must not end the search at once
+                double remainingIterations = m_Iterations - iter;
+                if (maxThinkTime && iter > 0 && elapsed.count() > 0)
+                    remainingIterations = std::min(remainingIterations, iter * (*maxThinkTime - elapsed) / elapsed);
+                const auto &root = Resolve(m_Tree->Root);
+                if (root->Type == NodeType::FullyExpanded) {
+                    const auto &fullExpNode = static_cast<const FullyExpandedNode &>(*root);
+                    const auto counts = fullExpNode.ChildRolloutCounts.get();
+                    if (IsSettled(counts, counts + fullExpNode.ActionCount, remainingIterations))
+                        break;
+                }
+            }
+        }
+        RunSingleIteration(*m_Tree, path, *m_Rollout, takenActions, *m_Instrumentation, m_WorkingState.get());
+    }
+    return ChooseBestActionSequential(*m_Tree);
 }
 
 void Player::Update(const Game::Action &action) {
     // It's OK to update action generator data while worker threads are running
     m_ActionGenerator->UpdateData(*m_ActionGeneratorData, *m_State, action);
-    if (m_Parallel) {
-        // If the action taken is not found in `m_ActionList`, `m_PruneActionIndex` is equal to `m_ActionList.size()`
-        m_PruneActionIndex =
-            std::find_if(m_ActionList.cbegin(), m_ActionList.cend(),
-                         [&](const std::unique_ptr<Game::Action> &actPtr) { return action.Equal(*actPtr); }) -
-            m_ActionList.cbegin();
+    // If the action taken is not found in `m_ActionList`, `m_PruneActionIndex` is equal to `m_ActionList.size()`
+    m_PruneActionIndex =
+        std::find_if(m_ActionList.cbegin(), m_ActionList.cend(),
+                     [&](const Game::ActionValue &actionValue) { return action.Equal(*actionValue); }) -
+        m_ActionList.cbegin();
+    m_PruneAction = action;
+    PruneTrees();
+    m_ActionList = m_ActionGenerator->GetActionList(*m_ActionGeneratorData, *m_State);
+}
+
+void Player::Reset() {
+    ::Player::Reset();
+    // The new state is unrelated to the old one, so the trees are discarded as if an unknown action was taken
+    m_PruneActionIndex = m_ActionList.size();
+    m_PruneAction.Reset();
+    PruneTrees();
+    m_ActionList = m_ActionGenerator->GetActionList(*m_ActionGeneratorData, *m_State);
+}
+
+void Player::PruneTrees() {
+    if (!m_Parallel)
+        Prune(*m_Tree);
+    else if (m_ParallelMode == ParallelMode::Tree) {
+        // The workers are paused while the shared tree is pruned
+        if (m_Thinking)
+            SendSignal(Signal::StopThinking);
+        Prune(*m_Tree);
+        if (m_Thinking)
+            SendSignal(Signal::StartThinking);
+    } else
         SendSignal(Signal::Prune);
-        m_ActionList = m_ActionGenerator->GetActionList(*m_ActionGeneratorData, *m_State);
+}
+
+static nlohmann::json GetMemoryJson(const MemoryPool::Statistics &statistics, uint64_t evictions,
+                                    uint64_t evictedNodes, uint64_t skippedExpansions) {
+    return {
+        {"allocations", statistics.Allocations},
+        {"bytesAllocated", statistics.BytesAllocated},
+        {"systemAllocations", statistics.SystemAllocations},
+        {"nodes", statistics.BlocksInUse},
+        {"bytesInUse", statistics.BytesInUse},
+        {"bytesReserved", statistics.BytesReserved},
+        {"evictions", evictions},
+        {"evictedNodes", evictedNodes},
+        {"skippedExpansions", skippedExpansions},
+    };
+}
+
+static nlohmann::json GetTranspositionTableJson(uint64_t lookups, uint64_t hits, std::size_t entries,
+                                                std::size_t capacity) {
+    return {
+        {"lookups", lookups},
+        {"hits", hits},
+        {"hitRate", lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups},
+        {"entries", entries},
+        {"occupancy", capacity == 0 ? 0.0 : static_cast<double>(entries) / capacity},
+    };
+}
+
+static nlohmann::json GetReuseJson(uint64_t prunes, uint64_t reusedPrunes, uint64_t reusedRollouts) {
+    return {
+        {"prunes", prunes},
+        {"reusedPrunes", reusedPrunes},
+        {"reuseRate", prunes == 0 ? 0.0 : static_cast<double>(reusedPrunes) / prunes},
+        {"reusedRollouts", reusedRollouts},
+    };
+}
+
+// `result` is null if the root is not proven
+static nlohmann::json GetSolverJson(uint64_t provenNodes, const Game::Result *result) {
+    nlohmann::json json = {{"provenNodes", provenNodes}};
+    if (result)
+        json["result"] = *result;
+    return json;
+}
+
+nlohmann::json Player::GetInstrumentationJson(const std::vector<const Instrumentation *> &counters,
+                                              const int64_t *nodeCounts) {
+    uint64_t iterations = 0, depthSum = 0, maxDepth = 0;
+    double iterationsPerSecond = 0;
+    std::array<double, Instrumentation::PhaseCount> phaseSeconds = {};
+    for (const auto data : counters) {
+        const auto workerIterations = data->Iterations.load(std::memory_order_relaxed);
+        uint64_t workerNanoseconds = 0;
+        for (std::size_t phase = 0; phase < Instrumentation::PhaseCount; ++phase) {
+            const auto nanoseconds = data->PhaseNanoseconds[phase].load(std::memory_order_relaxed);
+            phaseSeconds[phase] += nanoseconds / 1e9;
+            workerNanoseconds += nanoseconds;
+        }
+        // The workers run at the same time, so their speeds add up
+        if (workerNanoseconds > 0)
+            iterationsPerSecond += workerIterations / (workerNanoseconds / 1e9);
+        iterations += workerIterations;
+        depthSum += data->DepthSum.load(std::memory_order_relaxed);
+        maxDepth = std::max<uint64_t>(maxDepth, data->MaxDepth.load(std::memory_order_relaxed));
     }
+    const auto nodeCount = [&](NodeType type) { return nodeCounts[static_cast<std::size_t>(type)]; };
+    return {
+        {"iterations", iterations},
+        {"iterationsPerSecond", iterationsPerSecond},
+        {"meanDepth", iterations == 0 ? 0.0 : static_cast<double>(depthSum) / iterations},
+        {"maxDepth", maxDepth},
+        {"phaseSeconds",
+         {
+             {"select", phaseSeconds[Instrumentation::Select]},
+             {"expand", phaseSeconds[Instrumentation::Expand]},
+             {"rollout", phaseSeconds[Instrumentation::Rollout]},
+             {"backPropagate", phaseSeconds[Instrumentation::BackPropagate]},
+         }},
+        {"nodes",
+         {
+             {"terminal", nodeCount(NodeType::Terminal)},
+             {"new", nodeCount(NodeType::New)},
+             {"unexpanded", nodeCount(NodeType::Unexpanded)},
+             {"partiallyExpanded", nodeCount(NodeType::PartiallyExpanded)},
+             {"fullyExpanded", nodeCount(NodeType::FullyExpanded)},
+             {"shared", nodeCount(NodeType::Shared)},
+         }},
+    };
 }
 
 nlohmann::json Player::QueryDetails(const nlohmann::json &) {
-    if (!m_Parallel)
-        return nlohmann::json::object();
-    SendSignal(Signal::QueryDetails);
+    if (!m_Parallel) {
+        nlohmann::json details = {
+            {"totalRollouts", m_Tree->RootRolloutCount.load()},
+            {"inheritedRollouts", m_InheritedRolloutCount},
+            {"memory", GetMemoryJson(m_Tree->Pool.GetStatistics(), m_Tree->Evictions, m_Tree->EvictedNodes,
+                                     m_Tree->SkippedExpansions)},
+            {"reuse", GetReuseJson(m_Tree->Reuse.Prunes, m_Tree->Reuse.ReusedPrunes, m_Tree->Reuse.ReusedRollouts)},
+        };
+        if (m_Tree->Table) {
+            const auto &statistics = m_Tree->Table->Statistics;
+            details["transpositionTable"] = GetTranspositionTableJson(statistics.Lookups, statistics.Hits,
+                                                                      statistics.Entries, statistics.Capacity);
+        }
+        if (m_Solver)
+            details["solver"] =
+                GetSolverJson(m_Tree->ProvenNodes, m_Tree->ProvenChild ? &m_Tree->ProvenResult : nullptr);
+#ifdef MCTS_INSTRUMENTATION
+        std::array<int64_t, NodeTypeCount> nodeCounts;
+        for (std::size_t type = 0; type < NodeTypeCount; ++type)
+            nodeCounts[type] = m_Tree->Pool.NodeCounts[type].load(std::memory_order_relaxed);
+        details["instrumentation"] = GetInstrumentationJson({m_Instrumentation.get()}, nodeCounts.data());
+#endif
+        return details;
+    }
+    const auto reports = CollectReports();
     // Accumulate the data reported by each worker threads
     std::vector<unsigned int> actionRolloutCount(m_ActionList.size(), 0);
     std::vector<float> actionScore(m_ActionList.size(), 0.0f);
     unsigned int totalRolloutCount = 0;
-    for (const auto &data : m_ThreadList) {
+    MemoryPool::Statistics memoryStatistics;
+    EvictionStatistics evictionStatistics;
+    TranspositionTableStatistics transpositionStatistics;
+    ReuseStatistics reuseStatistics;
+    uint64_t provenNodes = 0;
+    const Game::Result *provenResult = nullptr;
+    for (const auto data : reports) {
+        provenNodes += data->ProvenNodes;
+        if (data->ProvenChild && !provenResult)
+            provenResult = &data->ProvenResult;
+        transpositionStatistics.Lookups += data->TranspositionStatistics.Lookups;
+        transpositionStatistics.Hits += data->TranspositionStatistics.Hits;
+        transpositionStatistics.Entries += data->TranspositionStatistics.Entries;
+        transpositionStatistics.Capacity += data->TranspositionStatistics.Capacity;
+        memoryStatistics.Allocations += data->MemoryStatistics.Allocations;
+        memoryStatistics.BytesAllocated += data->MemoryStatistics.BytesAllocated;
+        memoryStatistics.SystemAllocations += data->MemoryStatistics.SystemAllocations;
+        memoryStatistics.BlocksInUse += data->MemoryStatistics.BlocksInUse;
+        memoryStatistics.BytesInUse += data->MemoryStatistics.BytesInUse;
+        memoryStatistics.BytesReserved += data->MemoryStatistics.BytesReserved;
+        evictionStatistics.Evictions += data->Eviction.Evictions;
+        evictionStatistics.EvictedNodes += data->Eviction.EvictedNodes;
+        evictionStatistics.SkippedExpansions += data->Eviction.SkippedExpansions;
+        reuseStatistics.Prunes += data->Reuse.Prunes;
+        reuseStatistics.ReusedPrunes += data->Reuse.ReusedPrunes;
+        reuseStatistics.ReusedRollouts += data->Reuse.ReusedRollouts;
         if (data->ActionRolloutCount.size() == 0)
             continue;
         assert(data->ActionRolloutCount.size() == m_ActionList.size());
@@ -545,9 +1724,30 @@ nlohmann::json Player::QueryDetails(const nlohmann::json &) {
     std::sort(
         actionListJson.begin(), actionListJson.end(),
         [](const nlohmann::json &left, const nlohmann::json &right) { return left["rollouts"] > right["rollouts"]; });
-    return {
+    nlohmann::json details = {
         {"totalRollouts", totalRolloutCount},
         {"actions", std::move(actionListJson)},
+        {"memory", GetMemoryJson(memoryStatistics, evictionStatistics.Evictions, evictionStatistics.EvictedNodes,
+                                 evictionStatistics.SkippedExpansions)},
+        {"reuse", GetReuseJson(reuseStatistics.Prunes, reuseStatistics.ReusedPrunes, reuseStatistics.ReusedRollouts)},
     };
+    if (m_TranspositionTableSize > 0)
+        details["transpositionTable"] =
+            GetTranspositionTableJson(transpositionStatistics.Lookups, transpositionStatistics.Hits,
+                                      transpositionStatistics.Entries, transpositionStatistics.Capacity);
+    if (m_Solver)
+        details["solver"] = GetSolverJson(provenNodes, provenResult);
+#ifdef MCTS_INSTRUMENTATION
+    std::array<int64_t, NodeTypeCount> nodeCounts = {};
+    for (const auto data : reports)
+        for (std::size_t type = 0; type < NodeTypeCount; ++type)
+            nodeCounts[type] += data->NodeCounts[type];
+    // In tree parallelization, the report is of the shared tree, while the counters are kept by each worker
+    std::vector<const Instrumentation *> counters;
+    for (const auto &data : m_ThreadList)
+        counters.push_back(&data->Counters);
+    details["instrumentation"] = GetInstrumentationJson(counters, nodeCounts.data());
+#endif
+    return details;
 }
 } // namespace mcts
@@ -1,14 +1,21 @@
 #pragma once
 
 #include "../../Games/Game.hpp"
+#include "../../Utilities/MemoryPool.hpp"
+#include "../../Utilities/SpinLock.hpp"
 #include "../Player.hpp"
-#include <stack>
+#include "Rollout.hpp"
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 namespace mcts {
 class Player : public ::Player {
 private:
     // The explanation of the following `Node`s is detailed in the corresponding cpp file
+    enum class NodeType : uint8_t;
     struct Node;
     struct TerminalNode;
     struct NewNode;
@@ -16,10 +23,67 @@ private:
     struct ExpandedNode;
     struct PartiallyExpandedNode;
     struct FullyExpandedNode;
+    struct SharedNode;
+    // All-moves-as-first statistics of the children of an expanded node, only kept if RAVE is enabled
+    struct AMAFStatistics;
+    // Nodes have no virtual destructor, the deleter dispatches on the type tag and returns the memory to the pool
+    struct NodeDeleter {
+        void operator()(Node *node) const;
+    };
+    using NodePtr = std::unique_ptr<Node, NodeDeleter>;
+    // The memory pool of a game tree, which also counts the nodes of each type if instrumentation is enabled
+    struct NodePool;
+    // A game tree and the memory pool its nodes are allocated from
+    struct Tree;
+    // Statistics of the iterations run by one worker, see `MCTS_INSTRUMENTATION`
+    struct Instrumentation;
+    // Index of the `SharedNode`s of a tree by the hash of their states
+    struct TranspositionTable;
+    // The state of the node visited by a worker, walked from the root by taking and undoing actions, see `m_Replay`
+    struct WorkingState;
+    struct TranspositionTableStatistics {
+        uint64_t Lookups = 0;
+        uint64_t Hits = 0;
+        // The number of occupied slots, and the total number of slots
+        std::size_t Entries = 0;
+        std::size_t Capacity = 0;
+    };
+    struct EvictionStatistics {
+        // The number of subtrees collapsed into `UnexpandedNode`s, and the number of nodes released by that
+        uint64_t Evictions = 0;
+        uint64_t EvictedNodes = 0;
+        // The number of iterations that rolled out from the selected node without expanding it, because the tree was
+        // full
+        uint64_t SkippedExpansions = 0;
+    };
+    struct ReuseStatistics {
+        // The number of actions taken, and the number of them whose subtrees were kept as the new game trees
+        uint64_t Prunes = 0;
+        uint64_t ReusedPrunes = 0;
+        // The rollout counts of the kept subtrees
+        uint64_t ReusedRollouts = 0;
+    };
+    // The score of a child on the path from the root to the selected node, and the player who chose the child. It
+    // points into the child arrays rather than to the parent node, because the arrays are kept when the parent changes
+    // its type, which may happen in another thread during the rollout if the tree is shared. The AMAF statistics of the
+    // parent are kept in the same way, and are null if RAVE is disabled. `Child` is the slot of the child in the
+    // parent, which is replaced by the solver once the child is proven
+    struct PathItem {
+        NodePtr *Child;
+        std::atomic<float> *ScoreSum;
+        AMAFStatistics *AMAF;
+        uint32_t ChildIndex;
+        uint8_t Player;
+    };
 
     // Facilities for synchronizing threads
-    enum class Signal;
+    enum class Signal : uint8_t;
     struct ThreadData;
+    // The statistics of the root node and the tree, reported by a worker or read from the shared tree
+    struct Report;
+    // In root parallelization, each worker searches its own tree, and the children of the root are summed when choosing
+    // an action. In tree parallelization, all workers search one shared tree
+    enum class ParallelMode { Root, Tree };
 
     // Configurations of the MCTS algorithm, see `schema/players/mcts.schema.json` for details
     double m_ExplorationFactor;
@@ -27,40 +91,164 @@ private:
     std::string m_RolloutPolicyType;
     nlohmann::json m_RolloutPolicyData;
     bool m_Parallel;
+    ParallelMode m_ParallelMode = ParallelMode::Root;
     unsigned int m_Iterations = 0;
     unsigned int m_Workers = 0;
+    // The number of slots of the transposition table of each tree, zero if transpositions are not detected
+    unsigned int m_TranspositionTableSize = 0;
+    // Whether to return before the iterations or the think time are used up once the best action is settled
+    bool m_EarlyStop = false;
+    // The maximum number of nodes of each game tree, zero if unlimited
+    std::size_t m_MaxNodes = 0;
+    // The number of rollouts run from each selected node, whose average result is backpropagated as one visit
+    unsigned int m_RolloutsPerLeaf = 1;
+    // The number of rollouts of a child at which its average score and its AMAF score have equal weight, zero if RAVE
+    // is disabled
+    double m_RaveEquivalence = 0;
+    // Whether to prove the results of nodes from the terminal nodes below them, and stop searching proven subtrees
+    bool m_Solver = false;
+    // Whether each worker replays the actions from the root on its `WorkingState`, instead of storing states in nodes
+    bool m_Replay = false;
+    // The highest and the lowest possible score of each player, given that the result of each player is between 0 and
+    // 1. A node is proven a win for the player to move if a child reaches the highest score
+    std::vector<float> m_MaxScores;
+    std::vector<float> m_MinScores;
 
-    // The following fields are only used for the parallel MCTS algorithm
-    std::vector<std::unique_ptr<ThreadData>> m_ThreadList;
     // Actions available in the current state. When `Update` is called, `m_State` has changed, and no action information
     // is stored in the root node of the game tree, so this is needed to calculate the action index during `Prune`
-    std::vector<std::unique_ptr<Game::Action>> m_ActionList;
-    // Used to tell the worker threads which action was taken during `Prune`. If `m_PruneActionIndex` is out of bounds,
-    // it means that the opponent took an action that we did not consider.
+    std::vector<Game::ActionValue> m_ActionList;
+    // Used to tell which action was taken during `Prune`. If `m_PruneActionIndex` is out of bounds, it means that the
+    // opponent took an action that we did not consider.
     unsigned int m_PruneActionIndex;
+    // The action taken, empty if the state is reset. The children of a partially expanded root are `NewNode`s that keep
+    // their actions, so the child of the action is found by comparing with them
+    Game::ActionValue m_PruneAction;
+    // The game tree kept across moves by the sequential MCTS algorithm, or the tree shared by all workers in tree
+    // parallelization. In root parallelization, each worker owns its tree
+    std::unique_ptr<Tree> m_Tree;
+
+    // The following fields are only used for the sequential MCTS algorithm
+    // The rollout count of the root node inherited from the previous moves when the last `GetBestAction` was called
+    uint32_t m_InheritedRolloutCount = 0;
+    std::unique_ptr<Rollout> m_Rollout;
+    std::unique_ptr<Instrumentation> m_Instrumentation;
+    // Null unless replaying
+    std::unique_ptr<WorkingState> m_WorkingState;
+
+    // The following fields are only used for the parallel MCTS algorithm
+    std::vector<std::unique_ptr<ThreadData>> m_ThreadList;
+    // Whether the worker threads are running iterations, since they are paused while the shared tree is pruned
+    bool m_Thinking = false;
+
+    // The following fields are only used for tree parallelization
+    // The report of the shared tree, in the same form as the reports of the workers in root parallelization
+    std::unique_ptr<Report> m_SharedTreeReport;
 
-    // Traverse the tree and select a leaf node, or a partially expanded node
-    std::unique_ptr<Node> &Select(std::unique_ptr<Node> &root, std::stack<ExpandedNode *> &path) const;
-    // Expand the node if needed, return a node that is never visited
-    Node &Expand(std::unique_ptr<Player::Node> &node, std::stack<ExpandedNode *> &path) const;
-    // Rollout at the given node to estimate the value of the node
-    std::vector<float> Rollout(const Node &node, const std::stack<ExpandedNode *> &path) const;
-    // Update `Score` and `RolloutCount` along the path
-    void BackPropagate(Node *node, std::stack<ExpandedNode *> &path, const std::vector<float> &result) const;
-    // Create a new root node with the current state and action generator data
-    std::unique_ptr<Node> CreateRootNode() const;
-    // Call `Select`, `Expand`, `Rollout`, and `BackPropagate`
-    void RunSingleIteration(std::unique_ptr<Node> &root, std::stack<ExpandedNode *> &path) const;
-    // Choose the most visited action, given the root node. Used for the sequential MCTS algorithm
-    std::unique_ptr<Game::Action> ChooseBestActionSequential(const Node &root) const;
+    // Allocate a node of type `T` from the memory pool of the game tree
+    template <typename T, typename... TArgs>
+    static NodePtr CreateNode(NodePool &pool, TArgs &&... args);
+    // Return the slot holding the node itself if it's a `SharedNode`, otherwise the slot passed in
+    static NodePtr &Resolve(NodePtr &node);
+    static const NodePtr &Resolve(const NodePtr &node);
+    // Copy the root state into the working state if the root has been replaced since the last iteration
+    static void SyncWorkingState(WorkingState &workingState, const Tree &tree);
+    // The action of a child of an expanded node, which is kept in the child when replaying
+    static const Game::Action &GetReplayAction(const Node &node);
+    // Take the action on the working state, and return the result if it ends the game, in which case the action is
+    // undone right away, so the working state only ever holds non-terminal states
+    std::optional<Game::Result> TakeWorkingAction(WorkingState &workingState, const Game::Action &action) const;
+    // Undo the actions taken on the working state, back to the root state
+    void UndoWorkingActions(WorkingState &workingState) const;
+    // Traverse the tree and select a leaf node, or a partially expanded node. The rollout counts along the path are
+    // incremented on the way down, which serves as virtual loss if the tree is shared. In that case `lock` is given,
+    // the locks of the nodes are taken hand over hand, and the one guarding the selected node is held in `lock` on
+    // return. `workingState` is null unless replaying, in which case it's walked down to the state of the selected
+    // node. With the solver, the children proven to lose for the player to move are skipped
+    NodePtr &Select(Tree &tree, std::vector<PathItem> &path, std::unique_lock<SpinLock> *lock,
+                    WorkingState *workingState) const;
+    // The child with the largest UCB value among those not proven to lose, or `fallback` if all of them are. It's a
+    // scalar loop that looks at every child, so it's only called when the vectorized selection picks a proven loss
+    uint32_t SelectUnprovenChild(const ExpandedNode &node, uint32_t rolloutCount, uint32_t fallback) const;
+    // Expand the node if needed, return a node that is never visited and its parent, or the node itself and null if it
+    // is a terminal node or if the tree is full. The working state is walked down to the returned node
+    std::pair<const Node &, const ExpandedNode *> Expand(NodePtr &node, std::vector<PathItem> &path, Tree &tree,
+                                                         WorkingState *workingState) const;
+    // Create the AMAF statistics of the children of a node, or return null if RAVE is disabled
+    std::unique_ptr<AMAFStatistics> CreateAMAFStatistics(const Game::State &state,
+                                                         const ActionGenerator::Data &actionGeneratorData,
+                                                         uint32_t actionCount) const;
+    // Copy the state to perform rollout from into `state`, or return the result of the game if the state is terminal.
+    // `parent` is needed if the node is a `NewNode`, and the working state is copied if replaying
+    std::optional<Game::Result> GetRolloutStart(const Node &node, const ExpandedNode *parent, Game::State &state,
+                                                const WorkingState *workingState) const;
+    // The score of the result from the perspective of the player, see `m_GoalMatrix`
+    float GetScore(const Game::Result &result, uint8_t player) const;
+    // Whether the child is proven to be the worst result for the player to move at the node
+    bool IsProvenLoss(const ExpandedNode &node, uint32_t childIdx) const;
+    // Add the score of the result to the children along the path. If RAVE is enabled, also add it to the AMAF
+    // statistics of the children whose actions were taken later by the same player, in the tree or in `rolloutActions`,
+    // which is null if no rollout was run. `takenActions` is a buffer reused across iterations
+    void BackPropagate(std::vector<PathItem> &path, const Game::Result &result,
+                       const std::vector<PlayedAction> *rolloutActions, std::vector<uint8_t> &takenActions) const;
+    // Walk up the path while the children are proven, and mark their parents as proven if the player to move can win,
+    // or if all children are proven. A proven node is replaced by a `TerminalNode` of its exact result, and its subtree
+    // is released, except for the root, which is marked in the `Tree`. Only used if the tree is not shared
+    void Solve(Tree &tree, const std::vector<PathItem> &path) const;
+    // Replace the root node with a new one of the current state and action generator data
+    void ResetRoot(Tree &tree) const;
+    // Queue a subtree that is no longer reachable to be released by `ReleaseNodes`, so that the caller does not pay for
+    // destroying it
+    static void Discard(Tree &tree, NodePtr &&node);
+    // Release up to `maxCount` discarded nodes, one at a time instead of recursively. The children of a node are queued
+    // before it is destroyed. Returns at once if another thread is releasing the nodes of the shared tree
+    static void ReleaseNodes(Tree &tree, std::size_t maxCount = std::numeric_limits<std::size_t>::max());
+    static EvictionStatistics GetEvictionStatistics(const Tree &tree);
+    // Whether the number of nodes has reached `m_MaxNodes`
+    bool IsFull(const Tree &tree) const;
+    // Collapse the least visited subtrees into `UnexpandedNode`s, so that the number of nodes drops well below
+    // `m_MaxNodes`. Only used if the tree is not shared
+    void Evict(Tree &tree) const;
+    // Count the nodes of the subtree, and collect the rollout count and the size of each expanded subtree below it
+    static std::size_t CountSubtree(const Node &node, std::vector<std::pair<uint32_t, std::size_t>> &subtrees);
+    // Collapse the expanded subtrees below the node whose rollout counts do not exceed `maxRolloutCount`, `state` and
+    // `actionGeneratorData` are those of the node, or null if replaying, in which case no state is needed
+    void CollapseSubtrees(ExpandedNode &node, const Game::State *state,
+                          const ActionGenerator::Data *actionGeneratorData, uint32_t maxRolloutCount, Tree &tree) const;
+    // Call `Select`, `Expand`, `Rollout::Run`, and `BackPropagate`, and record the time of each phase into
+    // `instrumentation`. `workingState` is null unless replaying
+    void RunSingleIteration(Tree &tree, std::vector<PathItem> &path, Rollout &rollout,
+                            std::vector<uint8_t> &takenActions, Instrumentation &instrumentation,
+                            WorkingState *workingState) const;
+    // The same as `RunSingleIteration`, but on a tree shared by multiple threads. Only the rollout and the
+    // backpropagation run without holding a lock
+    void RunSingleIterationShared(Tree &tree, std::vector<PathItem> &path, Rollout &rollout,
+                                  std::vector<uint8_t> &takenActions, Instrumentation &instrumentation,
+                                  WorkingState *workingState) const;
+    // Choose the most visited action, given the game tree. Used for the sequential MCTS algorithm
+    Game::ActionValue ChooseBestActionSequential(const Tree &tree) const;
+    // Prune the game tree based on the action taken, and return the memory of the discarded nodes to the system
+    void Prune(Tree &tree) const;
+    // Prune the game tree of the sequential MCTS algorithm, or the trees of all workers
+    void PruneTrees();
 
     // The following methods are only used for the parallel MCTS algorithm
-    // Copy the visited count and score of each child of the given root node into the `ThreadData`
-    void ReportData(ThreadData &data, const Node &root, bool includeScore) const;
-    // Prune the game tree based on the action taken
-    void Prune(std::unique_ptr<Node> &root) const;
+    // Copy the visited count and score of each child of the root node, and the statistics of the tree into the `Report`
+    void ReportData(Report &data, const Tree &tree) const;
+    // Report the tree of a worker in root parallelization, and publish the report to the main thread
+    void PublishReport(ThreadData &data, const Tree &tree) const;
+    // Collect the latest reports of the root node, either published by the worker threads or read from the shared tree
+    std::vector<const Report *> CollectReports();
+    // Sum the rollout counts of each action in `m_ActionList` over the reports, leaving out the actions proven to lose
+    std::vector<unsigned int> SumActionRolloutCounts(const std::vector<const Report *> &reports) const;
+    // The index of the action that proves the root in any of the reports
+    static std::optional<uint32_t> FindProvenAction(const std::vector<const Report *> &reports);
+    // Wait until the think time is up, or until the best action is settled if early stop is enabled
+    void WaitParallel(std::chrono::duration<double> maxThinkTime);
     // Choose the most visited action. Used for the parallel MCTS algorithm
-    std::unique_ptr<Game::Action> ChooseBestActionParallel();
+    Game::ActionValue ChooseBestActionParallel();
+    // Aggregate the counters of the workers, and the number of nodes of each type indexed by `NodeType`
+    static nlohmann::json GetInstrumentationJson(const std::vector<const Instrumentation *> &counters,
+                                                 const int64_t *nodeCounts);
     // Main function for worker threads
     void ThreadMain(ThreadData *data);
     // Send a signal to worker threads and wait for all of them to reply
@@ -73,9 +261,9 @@ public:
     virtual std::string_view GetType() const override { return "mcts"; }
     virtual void StartThinking() override;
     virtual void StopThinking() override;
-    virtual std::unique_ptr<Game::Action>
-    GetBestAction(std::optional<std::chrono::duration<double>> maxThinkTime) override;
+    virtual Game::ActionValue GetBestAction(std::optional<std::chrono::duration<double>> maxThinkTime) override;
     virtual void Update(const Game::Action &action) override;
+    virtual void Reset() override;
     virtual nlohmann::json QueryDetails(const nlohmann::json &data) override;
 };
 } // namespace mcts
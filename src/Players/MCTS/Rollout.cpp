@@ -0,0 +1,133 @@
+#include "Rollout.hpp"
+#include "../../Games/AbstractGames/MNKGame/BatchedRollout.hpp"
+#include "../../Games/Gomoku/ActionGenerators/Default.hpp"
+#include "../../Games/Gomoku/ActionGenerators/Neighbor.hpp"
+#include "../../Games/Gomoku/Game.hpp"
+#include "../../Games/TicTacToe/ActionGenerators/Default.hpp"
+#include "../../Games/TicTacToe/Game.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace mcts {
+// Rollouts by the random move player on an m,n,k-game, where the games of `RunAverage` are played together by
+// `m_n_k_game::BatchedRollout`
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
+class MNKBatchedRollout final : public Rollout {
+private:
+    using Engine = m_n_k_game::BatchedRollout<RowCount, ColCount, Renju>;
+
+    Engine m_Engine;
+    typename Engine::State m_State;
+    std::vector<const typename Engine::State *> m_States;
+    std::vector<typename Engine::Result> m_Results;
+
+public:
+    explicit MNKBatchedRollout(std::optional<unsigned char> range) : m_Engine(range) {}
+
+    virtual Game::State &GetState() override { return m_State; }
+    virtual Game::Result Run() override { return RunAverage(1); }
+
+    virtual Game::Result RunAverage(unsigned int count) override {
+        // The state is not terminal, since terminal nodes are not rolled out
+        m_States.assign(count, &m_State);
+        m_Results.resize(count);
+        m_Engine.Run(m_States.data(), count, m_Results.data());
+        Game::Result result(2, 0.0f);
+        for (const auto &[score0, score1] : m_Results) {
+            result[0] += score0;
+            result[1] += score1;
+        }
+        for (auto &score : result)
+            score /= count;
+        return result;
+    }
+};
+
+template <typename TGame, typename TActionGenerator>
+static std::unique_ptr<Rollout> CreateSpecializedRollout(const Game &game, const nlohmann::json &actionGeneratorData) {
+    return std::make_unique<SpecializedRollout<TGame, TActionGenerator>>(game, actionGeneratorData);
+}
+
+// The random move player is specialized for these action generators, the keys are the same as the ones in
+// `ActionGeneartor.cpp`
+using RolloutCreatorFunc = std::unique_ptr<Rollout> (*)(const Game &, const nlohmann::json &);
+static const std::unordered_map<std::string, RolloutCreatorFunc> SpecializedRolloutCreatorMap = {
+    {"tic_tac_toe/default",
+     CreateSpecializedRollout<tic_tac_toe::Game, tic_tac_toe::action_generator::Default>},
+    {"gomoku/default", CreateSpecializedRollout<gomoku::Game, gomoku::action_generator::Default>},
+    {"gomoku/neighbor", CreateSpecializedRollout<gomoku::Game, gomoku::action_generator::Neighbor>},
+};
+
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju, bool Neighbor>
+static std::unique_ptr<Rollout> CreateBatchedRollout(const Game &, const nlohmann::json &actionGeneratorData) {
+    std::optional<unsigned char> range;
+    if constexpr (Neighbor)
+        range = actionGeneratorData["range"].get<unsigned char>();
+    return std::make_unique<MNKBatchedRollout<RowCount, ColCount, Renju>>(range);
+}
+
+// The random move player is batched for these action generators if more than one rollout is run from each leaf
+static const std::unordered_map<std::string, RolloutCreatorFunc> BatchedRolloutCreatorMap = {
+    {"tic_tac_toe/default", CreateBatchedRollout<3, 3, 3, false>},
+    {"gomoku/default", CreateBatchedRollout<15, 15, 5, false>},
+    {"gomoku/neighbor", CreateBatchedRollout<15, 15, 5, true>},
+};
+
+std::unique_ptr<Rollout> Rollout::Create(const std::string &type, const Game &game, const nlohmann::json &data,
+                                         unsigned int rolloutsPerLeaf) {
+    if (type == "random_move") {
+        Util::GetJsonValidator("players/random_move.schema.json").validate(data);
+        const auto &actionGeneratorJson = data["actionGenerator"];
+        const auto actionGeneratorType =
+            std::string(game.GetType()) + '/' + actionGeneratorJson["type"].get<std::string>();
+        const auto &creatorMap = rolloutsPerLeaf > 1 ? BatchedRolloutCreatorMap : SpecializedRolloutCreatorMap;
+        const auto iter = creatorMap.find(actionGeneratorType);
+        if (iter != creatorMap.cend()) {
+            Util::GetJsonValidator("action_generators/" + actionGeneratorType + ".schema.json")
+                .validate(actionGeneratorJson["data"]);
+            return iter->second(game, actionGeneratorJson["data"]);
+        }
+    }
+    return std::make_unique<PlayerRollout>(type, game, data);
+}
+
+Game::Result Rollout::RunAverage(unsigned int count) {
+    if (count == 1)
+        return Run();
+    if (m_Start)
+        m_Start->CopyFrom(GetState());
+    else
+        m_Start = GetState();
+    auto result = Run();
+    for (unsigned int idx = 1; idx < count; ++idx) {
+        GetState().CopyFrom(*m_Start);
+        const auto nextResult = Run();
+        std::transform(result.cbegin(), result.cend(), nextResult.cbegin(), result.begin(), std::plus<float>());
+    }
+    for (auto &score : result)
+        score /= count;
+    return result;
+}
+
+PlayerRollout::PlayerRollout(const std::string &type, const Game &game, const nlohmann::json &data)
+    : m_Game(&game), m_State(game.CreateDefaultState()),
+      m_Player(::Player::Create(type, game, *m_State, data)) {}
+
+Game::Result PlayerRollout::Run() {
+    m_Player->Reset();
+    m_PlayedActions.clear();
+    std::optional<Game::Result> result;
+    m_Player->StartThinking();
+    while (true) {
+        const auto &action = m_Player->ChooseAction();
+        if (m_RecordActions)
+            m_PlayedActions.push_back({m_Game->GetActionIndex(action), m_Game->GetNextPlayer(*m_State)});
+        result = m_Game->TakeAction(*m_State, action);
+        if (result)
+            break;
+        m_Player->Update(action);
+    }
+    m_Player->StopThinking();
+    return std::move(*result);
+}
+} // namespace mcts
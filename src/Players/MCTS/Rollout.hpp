@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../../Games/Game.hpp"
+#include "../../Utilities/Utilities.hpp"
+#include "../Player.hpp"
+#include <cstdint>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mcts {
+// An action played during a rollout, and the player who played it
+struct PlayedAction {
+    // See `Game::GetActionIndex`
+    uint32_t ActionIndex;
+    uint8_t Player;
+};
+
+// Plays a game from a state until it is over, which is how the MCTS algorithm estimates the value of a node. A rollout
+// is created once for each worker and reused by all its rollouts, so running it neither validates any schema nor
+// allocates any state.
+class Rollout : public Util::NonCopyableNonMoveable {
+private:
+    // A copy of the state to start from, only used by the default `RunAverage`
+    Game::StateValue m_Start;
+
+protected:
+    // Whether `Run` records the actions it plays into `m_PlayedActions`, which is cleared at the start of each `Run`
+    bool m_RecordActions = false;
+    std::vector<PlayedAction> m_PlayedActions;
+
+public:
+    // Create the rollout of a rollout player. The random move player on a game and action generator registered in
+    // `Rollout.cpp` is compiled into a `SpecializedRollout`, or into a batched rollout of the game if `rolloutsPerLeaf`
+    // is greater than one. Other players are played through the `Player` interface
+    static std::unique_ptr<Rollout> Create(const std::string &type, const Game &game, const nlohmann::json &data,
+                                           unsigned int rolloutsPerLeaf = 1);
+
+    virtual ~Rollout() = default;
+    // The state to perform rollout from, which is to be overwritten before each call to `Run`
+    virtual Game::State &GetState() = 0;
+    // Play from the state until the game is over, and return the result
+    virtual Game::Result Run() = 0;
+    // Play `count` games from the state, and return the average result. The state is overwritten
+    virtual Game::Result RunAverage(unsigned int count);
+
+    // Record the actions played by each `Run`, the game must number its actions. Not supported by batched rollouts
+    void RecordActions() { m_RecordActions = true; }
+    // The actions played by the last `Run`, in order, if they are recorded
+    const std::vector<PlayedAction> &GetPlayedActions() const { return m_PlayedActions; }
+};
+
+// Rollout by any player through the virtual `Player` interface
+class PlayerRollout final : public Rollout {
+private:
+    const Game *m_Game;
+    Game::StateValue m_State;
+    std::unique_ptr<::Player> m_Player;
+
+public:
+    explicit PlayerRollout(const std::string &type, const Game &game, const nlohmann::json &data);
+
+    virtual Game::State &GetState() override { return *m_State; }
+    virtual Game::Result Run() override;
+};
+
+// Rollout by the random move player, compiled for one game and action generator. `TGame` and `TActionGenerator` must
+// be final classes, so that every call below is resolved at compile time and can be inlined, and the state, the action
+// generator data and the iterator are held by value
+template <typename TGame, typename TActionGenerator>
+class SpecializedRollout final : public Rollout {
+private:
+    const TGame *m_Game;
+    TActionGenerator m_ActionGenerator;
+    typename TGame::State m_State;
+    typename TActionGenerator::Data m_ActionGeneratorData;
+    typename TActionGenerator::Iterator m_Iterator;
+
+public:
+    explicit SpecializedRollout(const Game &game, const nlohmann::json &actionGeneratorData)
+        : m_Game(&static_cast<const TGame &>(game)), m_ActionGenerator(*m_Game, actionGeneratorData), m_Iterator(0) {}
+
+    virtual Game::State &GetState() override { return m_State; }
+
+    virtual Game::Result Run() override {
+        auto &engine = Util::GetRandomEngine();
+        m_PlayedActions.clear();
+        m_ActionGenerator.ResetData(m_ActionGeneratorData, m_State);
+        while (true) {
+            // The same as `ActionGenerator::ChooseRandomAction`
+            const auto count = m_ActionGenerator.GetActionCount(m_ActionGeneratorData, m_State);
+            std::uniform_int_distribution<unsigned int> random(0, count - 1);
+            auto idx = random(engine);
+            m_ActionGenerator.ResetIterator(m_ActionGeneratorData, m_State, m_Iterator);
+            while (idx--)
+                m_ActionGenerator.NextIterator(m_ActionGeneratorData, m_State, m_Iterator);
+            const auto &action = m_Iterator.Action;
+            if (m_RecordActions)
+                m_PlayedActions.push_back({m_Game->GetActionIndex(action), m_Game->GetNextPlayer(m_State)});
+            if (auto result = m_Game->TakeAction(m_State, action))
+                return std::move(*result);
+            m_ActionGenerator.UpdateData(m_ActionGeneratorData, m_State, action);
+        }
+    }
+};
+} // namespace mcts
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Vectorized child selection for the UCB formula `sum / n + explorationFactor * sqrt(2 * ln(N) / n)`, where `sum` is
+// the total score of the child, `n` is the rollout count of the child, and `N` is the rollout count of the parent. The
+// formula is rewritten as `r * (sum * r + explorationFactor * sqrt(2 * ln(N)))` with `r = rsqrt(n)`: the parent term is
+// looked up in a table, and the reciprocal square roots of the child counts are computed in batches, so there is no
+// `log`, `sqrt` or division per child. AVX2 and SSE2 are used when enabled at compile time, otherwise a scalar loop is
+// used.
+namespace mcts::ucb {
+// `sqrt(2 * ln(n))` for small `n`, which covers all nodes except the ones near the root
+inline constexpr uint32_t ParentTermTableSize = 4096;
+inline const auto ParentTermTable = [] {
+    std::array<float, ParentTermTableSize> table = {};
+    for (uint32_t n = 1; n < ParentTermTableSize; ++n)
+        table[n] = static_cast<float>(std::sqrt(2 * std::log(static_cast<double>(n))));
+    return table;
+}();
+
+inline float GetParentTerm(uint32_t parentRolloutCount) {
+    if (parentRolloutCount < ParentTermTableSize)
+        return ParentTermTable[parentRolloutCount];
+    return static_cast<float>(std::sqrt(2 * std::log(static_cast<double>(parentRolloutCount))));
+}
+
+// The UCB value of one child, where `coef` is `explorationFactor * GetParentTerm(parentRolloutCount)`
+inline float GetUCB(float scoreSum, uint32_t rolloutCount, float coef) {
+    const auto r = 1 / std::sqrt(static_cast<float>(rolloutCount));
+    return r * (scoreSum * r + coef);
+}
+
+// The UCB value of one child with RAVE, see `SelectChildRAVE`
+inline float GetUCBRAVE(float scoreSum, uint32_t rolloutCount, float amafScoreSum, uint32_t amafRolloutCount,
+                        float coef, float equivalence) {
+    const auto count = static_cast<float>(rolloutCount);
+    const auto r = 1 / std::sqrt(count);
+    const auto mean = scoreSum / count;
+    const auto amafMean = amafRolloutCount > 0 ? amafScoreSum / static_cast<float>(amafRolloutCount) : mean;
+    const auto beta = std::sqrt(equivalence / (3 * count + equivalence));
+    return mean + beta * (amafMean - mean) + coef * r;
+}
+
+#if defined(__AVX2__)
+// Approximate reciprocal square root refined by one Newton-Raphson step, accurate to about 23 bits
+inline __m256 RSqrt(__m256 x) {
+    const auto y = _mm256_rsqrt_ps(x);
+    const auto xyy = _mm256_mul_ps(_mm256_mul_ps(x, y), y);
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), y), _mm256_sub_ps(_mm256_set1_ps(3.0f), xyy));
+}
+#elif defined(__SSE2__)
+inline __m128 RSqrt(__m128 x) {
+    const auto y = _mm_rsqrt_ps(x);
+    const auto xyy = _mm_mul_ps(_mm_mul_ps(x, y), y);
+    return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.0f), xyy));
+}
+#endif
+
+// Return the index of the child with the largest UCB value, ties are broken in favor of the smaller index. Every child
+// must have been visited at least once
+inline uint32_t SelectChild(const float *scoreSums, const uint32_t *rolloutCounts, uint32_t count,
+                            uint32_t parentRolloutCount, float explorationFactor) {
+    const auto coef = explorationFactor * GetParentTerm(parentRolloutCount);
+    auto maxUCB = std::numeric_limits<float>::lowest();
+    uint32_t maxIdx = 0, idx = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+    constexpr uint32_t Lanes = 8;
+    if (count >= Lanes) {
+        const auto coefVec = _mm256_set1_ps(coef);
+        auto maxVec = _mm256_set1_ps(maxUCB);
+        auto maxIdxVec = _mm256_setzero_si256();
+        auto idxVec = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const auto step = _mm256_set1_epi32(Lanes);
+        for (; idx + Lanes <= count; idx += Lanes) {
+            const auto scoreSum = _mm256_loadu_ps(scoreSums + idx);
+            const auto rolloutCount =
+                _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(rolloutCounts + idx)));
+            const auto r = RSqrt(rolloutCount);
+            const auto ucb = _mm256_mul_ps(r, _mm256_add_ps(_mm256_mul_ps(scoreSum, r), coefVec));
+            // Each lane keeps its first maximum, since the comparison is strict
+            const auto greater = _mm256_cmp_ps(ucb, maxVec, _CMP_GT_OQ);
+            maxVec = _mm256_blendv_ps(maxVec, ucb, greater);
+            maxIdxVec = _mm256_castps_si256(
+                _mm256_blendv_ps(_mm256_castsi256_ps(maxIdxVec), _mm256_castsi256_ps(idxVec), greater));
+            idxVec = _mm256_add_epi32(idxVec, step);
+        }
+        alignas(32) std::array<float, Lanes> laneMax;
+        alignas(32) std::array<uint32_t, Lanes> laneMaxIdx;
+        _mm256_store_ps(laneMax.data(), maxVec);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(laneMaxIdx.data()), maxIdxVec);
+#else
+    constexpr uint32_t Lanes = 4;
+    if (count >= Lanes) {
+        const auto coefVec = _mm_set1_ps(coef);
+        auto maxVec = _mm_set1_ps(maxUCB);
+        auto maxIdxVec = _mm_setzero_si128();
+        auto idxVec = _mm_setr_epi32(0, 1, 2, 3);
+        const auto step = _mm_set1_epi32(Lanes);
+        for (; idx + Lanes <= count; idx += Lanes) {
+            const auto scoreSum = _mm_loadu_ps(scoreSums + idx);
+            const auto rolloutCount =
+                _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rolloutCounts + idx)));
+            const auto r = RSqrt(rolloutCount);
+            const auto ucb = _mm_mul_ps(r, _mm_add_ps(_mm_mul_ps(scoreSum, r), coefVec));
+            // Each lane keeps its first maximum, since the comparison is strict. SSE2 has no blend instruction, so
+            // the selection is done with bitwise operations
+            const auto greater = _mm_cmpgt_ps(ucb, maxVec);
+            maxVec = _mm_or_ps(_mm_and_ps(greater, ucb), _mm_andnot_ps(greater, maxVec));
+            const auto greaterInt = _mm_castps_si128(greater);
+            maxIdxVec = _mm_or_si128(_mm_and_si128(greaterInt, idxVec), _mm_andnot_si128(greaterInt, maxIdxVec));
+            idxVec = _mm_add_epi32(idxVec, step);
+        }
+        alignas(16) std::array<float, Lanes> laneMax;
+        alignas(16) std::array<uint32_t, Lanes> laneMaxIdx;
+        _mm_store_ps(laneMax.data(), maxVec);
+        _mm_store_si128(reinterpret_cast<__m128i *>(laneMaxIdx.data()), maxIdxVec);
+#endif
+        // Reduce the lanes, the lane with the smaller index wins on ties
+        for (uint32_t lane = 0; lane < Lanes; ++lane)
+            if (laneMax[lane] > maxUCB || (laneMax[lane] == maxUCB && laneMaxIdx[lane] < maxIdx)) {
+                maxUCB = laneMax[lane];
+                maxIdx = laneMaxIdx[lane];
+            }
+    }
+#endif
+    // Scalar loop for the remaining children, or for all children if SIMD is not available
+    for (; idx < count; ++idx) {
+        const auto ucb = GetUCB(scoreSums[idx], rolloutCounts[idx], coef);
+        if (ucb > maxUCB) {
+            maxUCB = ucb;
+            maxIdx = idx;
+        }
+    }
+    return maxIdx;
+}
+
+// The same as `SelectChild`, but with RAVE: the average score of a child is blended with its all-moves-as-first (AMAF)
+// average score as `(1 - beta) * sum / n + beta * amafSum / amafN`, where `beta = sqrt(equivalence / (3 * n +
+// equivalence))`, so both have equal weight when `n` equals `equivalence`, and the AMAF score fades out as the child is
+// visited. A child without AMAF samples uses its own average. There is only a scalar loop, since the rollouts saved by
+// RAVE outweigh the cost of selection
+inline uint32_t SelectChildRAVE(const float *scoreSums, const uint32_t *rolloutCounts, const float *amafScoreSums,
+                                const uint32_t *amafRolloutCounts, uint32_t count, uint32_t parentRolloutCount,
+                                float explorationFactor, float equivalence) {
+    const auto coef = explorationFactor * GetParentTerm(parentRolloutCount);
+    auto maxUCB = std::numeric_limits<float>::lowest();
+    uint32_t maxIdx = 0;
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        const auto ucb = GetUCBRAVE(scoreSums[idx], rolloutCounts[idx], amafScoreSums[idx], amafRolloutCounts[idx],
+                                    coef, equivalence);
+        if (ucb > maxUCB) {
+            maxUCB = ucb;
+            maxIdx = idx;
+        }
+    }
+    return maxIdx;
+}
+} // namespace mcts::ucb
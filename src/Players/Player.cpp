@@ -1,7 +1,11 @@
 #include "Player.hpp"
+#include "../Games/Gomoku/Game.hpp"
+#include "../Games/TicTacToe/Game.hpp"
 #include "../Utilities/Utilities.hpp"
 #include "MCTS/Player.hpp"
 #include "RandomMove/Player.hpp"
+#include "ThreatMove/Player.hpp"
+#include <stdexcept>
 #include <unordered_map>
 
 template <typename T>
@@ -9,10 +13,21 @@ static std::unique_ptr<Player> CreatePlayer(const Game &game, const Game::State
     return std::make_unique<T>(game, state, data);
 }
 
+// The threat move player is compiled for each m,n,k-game
+static std::unique_ptr<Player> CreateThreatMovePlayer(const Game &game, const Game::State &state,
+                                                      const nlohmann::json &data) {
+    if (dynamic_cast<const gomoku::Game *>(&game))
+        return std::make_unique<threat_move::Player<15, 15, 5>>(game, state, data);
+    if (dynamic_cast<const tic_tac_toe::Game *>(&game))
+        return std::make_unique<threat_move::Player<3, 3, 3>>(game, state, data);
+    throw std::invalid_argument("The threat move player does not support the game " + std::string(game.GetType()));
+}
+
 using PlayerCreatorFunc = std::unique_ptr<Player> (*)(const Game &, const Game::State &, const nlohmann::json &);
 static const std::unordered_map<std::string, PlayerCreatorFunc> PlayerCreatorMap = {
     {"random_move", CreatePlayer<random_move::Player>},
     {"mcts", CreatePlayer<mcts::Player>},
+    {"threat_move", CreateThreatMovePlayer},
 };
 
 std::unique_ptr<Player> Player::Create(const std::string &type, const Game &game, const Game::State &state,
@@ -11,6 +11,10 @@
 #include <string_view>
 
 class Player : public Util::NonCopyableNonMoveable {
+private:
+    // The action returned by the default implementation of `ChooseAction`
+    Game::ActionValue m_ChosenAction;
+
 protected:
     const Game *m_Game;
     const Game::State *m_State;
@@ -27,9 +31,19 @@ public:
 
     virtual void StartThinking() {}
     virtual void StopThinking() {}
-    virtual std::unique_ptr<Game::Action> GetBestAction(std::optional<std::chrono::duration<double>> maxThinkTime) = 0;
+    virtual Game::ActionValue GetBestAction(std::optional<std::chrono::duration<double>> maxThinkTime) = 0;
     virtual void Update(const Game::Action &action) {
         m_ActionGenerator->UpdateData(*m_ActionGeneratorData, *m_State, action);
     }
     virtual nlohmann::json QueryDetails(const nlohmann::json &) { return nlohmann::json::object(); }
+
+    // The following methods let one player play many games, which is how rollout policies are used. `Reset` is called
+    // after the state has been overwritten by another one, and `ChooseAction` is the same as `GetBestAction` without a
+    // time limit, but the returned action is only valid until the next call. Players should override them to avoid
+    // allocating memory on each move
+    virtual void Reset() { m_ActionGenerator->ResetData(*m_ActionGeneratorData, *m_State); }
+    virtual const Game::Action &ChooseAction() {
+        m_ChosenAction = GetBestAction(std::nullopt);
+        return *m_ChosenAction;
+    }
 };
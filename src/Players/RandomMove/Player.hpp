@@ -4,13 +4,23 @@
 
 namespace random_move {
 class Player : public ::Player {
+private:
+    // Created on the first call of `ChooseAction`, and reused afterwards
+    std::unique_ptr<ActionGenerator::Iterator> m_Iterator;
+
 public:
     explicit Player(const Game &game, const Game::State &state, const nlohmann::json &data)
         : ::Player(game, state, data) {}
     virtual std::string_view GetType() const override { return "random_move"; }
 
-    virtual std::unique_ptr<Game::Action> GetBestAction(std::optional<std::chrono::duration<double>>) override {
+    virtual Game::ActionValue GetBestAction(std::optional<std::chrono::duration<double>>) override {
         return m_ActionGenerator->GetRandomAction(*m_ActionGeneratorData, *m_State);
     }
+
+    virtual const Game::Action &ChooseAction() override {
+        if (!m_Iterator)
+            m_Iterator = m_ActionGenerator->FirstIterator(*m_ActionGeneratorData, *m_State);
+        return m_ActionGenerator->ChooseRandomAction(*m_ActionGeneratorData, *m_State, *m_Iterator);
+    }
 };
 } // namespace random_move
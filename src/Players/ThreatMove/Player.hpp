@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../../Games/AbstractGames/MNKGame/Threats.hpp"
+#include "../Player.hpp"
+#include <random>
+
+namespace threat_move {
+// Plays like the random move player, except that it takes the first of these moves that exists: a move that wins, a move
+// that blocks a win of the opponent, a move that makes an open four, and a move that blocks an open four of the opponent
+// (i.e. the end of an open three). Only supports m,n,k-games
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
+class Player : public ::Player {
+private:
+    using Threats = m_n_k_game::Threats<RowCount, ColCount, Renju>;
+    using State = typename m_n_k_game::Game<RowCount, ColCount, Renju>::State;
+    using Action = typename m_n_k_game::Game<RowCount, ColCount, Renju>::Action;
+
+    Threats m_Threats;
+    Action m_Action;
+    // Created on the first random move, and reused afterwards
+    std::unique_ptr<ActionGenerator::Iterator> m_Iterator;
+
+    const State &GetState() const { return static_cast<const State &>(*m_State); }
+
+    // Choose a random grid from the non-empty set
+    static unsigned int ChooseGrid(const typename Threats::BitBoard &grids) {
+        std::uniform_int_distribution<unsigned int> random(0, grids.Count() - 1);
+        auto position = grids.FindNext(0);
+        for (auto idx = random(Util::GetRandomEngine()); idx > 0; --idx)
+            position = grids.FindNext(position + 1);
+        return position;
+    }
+
+public:
+    explicit Player(const Game &game, const Game::State &state, const nlohmann::json &data)
+        : ::Player(game, state, data) {
+        m_Threats.Reset(GetState());
+    }
+    virtual std::string_view GetType() const override { return "threat_move"; }
+
+    virtual Game::ActionValue GetBestAction(std::optional<std::chrono::duration<double>>) override {
+        return Game::ActionValue(ChooseAction());
+    }
+
+    virtual void Update(const Game::Action &action_) override {
+        ::Player::Update(action_);
+        const auto &action = static_cast<const Action &>(action_);
+        m_Threats.Update(action.Position, GetState().GetGrid(action.Position) - 1);
+    }
+
+    virtual void Reset() override {
+        ::Player::Reset();
+        m_Threats.Reset(GetState());
+    }
+
+    virtual const Game::Action &ChooseAction() override {
+        const unsigned char player = GetState().MoveCount % 2, opponent = 1 - player;
+        for (const auto &[threat, threatPlayer] : {std::pair(Threats::Five, player), {Threats::Five, opponent},
+                                                   {Threats::OpenFour, player}, {Threats::OpenFour, opponent}}) {
+            const auto &grids = m_Threats.GetGrids(threat, threatPlayer);
+            if (grids.Any()) {
+                m_Action.Position = ChooseGrid(grids);
+                return m_Action;
+            }
+        }
+        if (!m_Iterator)
+            m_Iterator = m_ActionGenerator->FirstIterator(*m_ActionGeneratorData, *m_State);
+        return m_ActionGenerator->ChooseRandomAction(*m_ActionGeneratorData, *m_State, *m_Iterator);
+    }
+};
+} // namespace threat_move
@@ -91,7 +91,7 @@ nlohmann::json Server::AddPlayer(const nlohmann::json &data) {
     unsigned int id;
     AccessState(data, [&](const GameRecord &gameRecord, StateRecord &stateRecord) {
         const std::shared_lock lock(stateRecord.MtxState);
-        auto player = Player::Create(data["type"], *gameRecord.GamePtr, *stateRecord.StatePtr, data["data"]);
+        auto player = Player::Create(data["type"], *gameRecord.GamePtr, *stateRecord.State, data["data"]);
         id = stateRecord.SubPlayers.Emplace(std::move(player));
     });
     return {{"playerID", id}};
@@ -102,7 +102,7 @@ nlohmann::json Server::AddActionGenerator(const nlohmann::json &data) {
     AccessState(data, [&](const GameRecord &gameRecord, StateRecord &stateRecord) {
         auto actionGenerator = ActionGenerator::Create(data["type"], *gameRecord.GamePtr, data["data"]);
         const std::shared_lock lock(stateRecord.MtxState);
-        auto actionGeneratorData = actionGenerator->CreateData(*stateRecord.StatePtr);
+        auto actionGeneratorData = actionGenerator->CreateData(*stateRecord.State);
         id = stateRecord.SubActionGenerators.Emplace(std::move(actionGenerator), std::move(actionGeneratorData));
     });
     return {{"actionGeneratorID", id}};
@@ -135,7 +135,7 @@ nlohmann::json Server::GenerateActions(const nlohmann::json &data) {
     nlohmann::json actions;
     AccessActionGenerator(data, [&](const GameRecord &, const StateRecord &stateRecord,
                                     const ActionGeneratorRecord &actionGeneratorRecord) {
-        const auto &state = *stateRecord.StatePtr;
+        const auto &state = *stateRecord.State;
         const auto &actionGenerator = *actionGeneratorRecord.ActionGeneratorPtr;
         const auto &actionGeneratorData = *actionGeneratorRecord.ActionGeneratorDataPtr;
         // Always lock state before locking player or action generator
@@ -152,7 +152,7 @@ nlohmann::json Server::TakeAction(const nlohmann::json &data) {
     nlohmann::json response;
     AccessState(data, [&](const GameRecord &gameRecord, const StateRecord &stateRecord) {
         const auto &game = *gameRecord.GamePtr;
-        auto &state = *stateRecord.StatePtr;
+        auto &state = *stateRecord.State;
         const auto action = game.CreateAction(data["action"]);
         if (!game.IsValidAction(state, *action))
             throw std::invalid_argument("The action is invalid");
@@ -211,7 +211,7 @@ nlohmann::json Server::GetBestAction(const nlohmann::json &data) {
         time = std::chrono::duration<double>(data["maxThinkTime"]);
     nlohmann::json bestActionJson;
     AccessPlayer(data, [&](const GameRecord &, const StateRecord &stateRecord, const PlayerRecord &playerRecord) {
-        std::unique_ptr<Game::Action> bestAction;
+        Game::ActionValue bestAction;
         {
             // Always lock state before locking player or action generator
             const std::shared_lock lockState(stateRecord.MtxState);
@@ -242,9 +242,11 @@ nlohmann::json Server::QueryDetails(const nlohmann::json &data) {
 nlohmann::json Server::RunGames(const nlohmann::json &data) {
     const unsigned int rounds = data["rounds"];
     const auto playerCount = data["players"].size();
+    if (playerCount > Game::MaxPlayerCount)
+        throw std::invalid_argument("There are more players than any game has");
     const auto game = Game::Create(data["game"]["type"], data["game"]["data"]);
-    const auto runGame = [&](std::vector<float> &result) {
-        const auto state = game->CreateDefaultState();
+    const auto runGame = [&](Game::Result &result) {
+        auto state = game->CreateDefaultState();
         // player, maxThinkTime, allowBackgroundThinking
         std::vector<std::tuple<std::unique_ptr<Player>, std::optional<std::chrono::duration<double>>, bool>> players;
         // Create players
@@ -270,7 +272,7 @@ nlohmann::json Server::RunGames(const nlohmann::json &data) {
                 player->StopThinking();
             auto actionResult = game->TakeAction(*state, *action);
             if (actionResult) {
-                result = std::move(*actionResult);
+                result = *actionResult;
                 break;
             }
             for (const auto &[player, maxThinkTime, allowBackgroundThinking] : players)
@@ -281,12 +283,12 @@ nlohmann::json Server::RunGames(const nlohmann::json &data) {
             if (allowBackgroundThinking)
                 player->StopThinking();
     };
-    std::vector<std::vector<float>> results(rounds);
+    std::vector<Game::Result> results(rounds);
     if (data["parallel"])
         tbb::parallel_for_each(results, runGame);
     else
         std::for_each(results.begin(), results.end(), runGame);
-    std::vector<float> finalResult(playerCount, 0.0f);
+    Game::Result finalResult(playerCount, 0.0f);
     for (const auto &result : results) {
         assert(result.size() == playerCount);
         for (unsigned int idx = 0; idx < playerCount; ++idx)
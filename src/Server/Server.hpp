@@ -31,11 +31,13 @@ private:
     struct StateRecord {
         // Used to lock the `State` object
         mutable std::shared_mutex MtxState;
-        const std::unique_ptr<Game::State> StatePtr;
+        // Held by value, and changed by `TakeAction` through a const record under `MtxState`. The players and action
+        // generators of the state refer to it, and the record never moves
+        mutable Game::StateValue State;
         ConcurrentIDMap<PlayerRecord> SubPlayers;
         ConcurrentIDMap<ActionGeneratorRecord> SubActionGenerators;
 
-        explicit StateRecord(std::unique_ptr<Game::State> &&statePtr) : StatePtr(std::move(statePtr)) {}
+        explicit StateRecord(Game::StateValue &&state) : State(std::move(state)) {}
     };
 
     struct PlayerRecord {
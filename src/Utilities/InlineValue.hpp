@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Holds a copy of an object of any class derived from `T` by value, like a `std::unique_ptr<T>` that is copyable and
+// does not allocate for small objects. The object is copy-constructed into the inline buffer of `Capacity` bytes if it
+// fits, and on the heap otherwise. `T` must have a virtual destructor and provide `GetSize`, the size of the derived
+// class, `CloneAt`, which copy-constructs the object at the given memory aligned like `std::max_align_t`, and `Clone`,
+// which copies it onto the heap. An empty value holds nothing, like a null pointer.
+template <typename T, std::size_t Capacity>
+class InlineValue {
+public:
+    static constexpr std::size_t InlineCapacity = Capacity;
+
+private:
+    alignas(std::max_align_t) unsigned char m_Buffer[Capacity];
+    // Points into `m_Buffer` if the object is inline, to the heap if it is not, or null if empty
+    T *m_Ptr = nullptr;
+
+    // `T` may not be the first base of the object, so the pointer is anywhere in the buffer
+    bool IsInline() const {
+        return reinterpret_cast<uintptr_t>(m_Ptr) - reinterpret_cast<uintptr_t>(m_Buffer) < Capacity;
+    }
+
+    void Emplace(const T &value) {
+        m_Ptr = value.GetSize() <= Capacity ? value.CloneAt(m_Buffer) : value.Clone().release();
+    }
+
+    // An inline object is copied, since it cannot be moved without knowing its class
+    void TakeFrom(InlineValue &other) {
+        if (!other.m_Ptr)
+            return;
+        if (other.IsInline()) {
+            Emplace(*other.m_Ptr);
+            other.Reset();
+        } else
+            m_Ptr = std::exchange(other.m_Ptr, nullptr);
+    }
+
+public:
+    InlineValue() = default;
+    explicit InlineValue(const T &value) { Emplace(value); }
+    InlineValue(const InlineValue &other) {
+        if (other.m_Ptr)
+            Emplace(*other.m_Ptr);
+    }
+    InlineValue(InlineValue &&other) { TakeFrom(other); }
+    ~InlineValue() { Reset(); }
+
+    InlineValue &operator=(const InlineValue &other) {
+        if (this != &other) {
+            Reset();
+            if (other.m_Ptr)
+                Emplace(*other.m_Ptr);
+        }
+        return *this;
+    }
+    InlineValue &operator=(InlineValue &&other) {
+        if (this != &other) {
+            Reset();
+            TakeFrom(other);
+        }
+        return *this;
+    }
+    // Replace the object with a copy of `value`, which must not be the object held
+    InlineValue &operator=(const T &value) {
+        Reset();
+        Emplace(value);
+        return *this;
+    }
+
+    void Reset() {
+        if (!m_Ptr)
+            return;
+        if (IsInline())
+            m_Ptr->~T();
+        else
+            delete m_Ptr;
+        m_Ptr = nullptr;
+    }
+
+    T *Get() { return m_Ptr; }
+    const T *Get() const { return m_Ptr; }
+    T &operator*() { return *m_Ptr; }
+    const T &operator*() const { return *m_Ptr; }
+    T *operator->() { return m_Ptr; }
+    const T *operator->() const { return m_Ptr; }
+    explicit operator bool() const { return m_Ptr != nullptr; }
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+// A vector of at most `Capacity` elements held inline, which never allocates. It has the part of the interface of
+// `std::vector` its users need, so that it can be passed to the standard algorithms and converted to JSON like one.
+// The elements beyond the size are value-initialized and kept, so `T` should be cheap to construct, like a number
+template <typename T, std::size_t Capacity>
+class InlineVector {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    static constexpr std::size_t InlineCapacity = Capacity;
+
+private:
+    std::array<T, Capacity> m_Data = {};
+    std::size_t m_Size = 0;
+
+public:
+    constexpr InlineVector() = default;
+    constexpr InlineVector(std::size_t size, const T &value) { assign(size, value); }
+
+    constexpr void assign(std::size_t size, const T &value) {
+        assert(size <= Capacity);
+        for (std::size_t idx = 0; idx < size; ++idx)
+            m_Data[idx] = value;
+        m_Size = size;
+    }
+    constexpr void push_back(const T &value) {
+        assert(m_Size < Capacity);
+        m_Data[m_Size++] = value;
+    }
+    constexpr void clear() { m_Size = 0; }
+
+    constexpr std::size_t size() const { return m_Size; }
+    static constexpr std::size_t capacity() { return Capacity; }
+    constexpr bool empty() const { return m_Size == 0; }
+
+    constexpr T &operator[](std::size_t idx) {
+        assert(idx < m_Size);
+        return m_Data[idx];
+    }
+    constexpr const T &operator[](std::size_t idx) const {
+        assert(idx < m_Size);
+        return m_Data[idx];
+    }
+
+    constexpr T *data() { return m_Data.data(); }
+    constexpr const T *data() const { return m_Data.data(); }
+    constexpr T *begin() { return m_Data.data(); }
+    constexpr const T *begin() const { return m_Data.data(); }
+    constexpr const T *cbegin() const { return m_Data.data(); }
+    constexpr T *end() { return m_Data.data() + m_Size; }
+    constexpr const T *end() const { return m_Data.data() + m_Size; }
+    constexpr const T *cend() const { return m_Data.data() + m_Size; }
+
+    friend constexpr bool operator==(const InlineVector &left, const InlineVector &right) {
+        if (left.m_Size != right.m_Size)
+            return false;
+        for (std::size_t idx = 0; idx < left.m_Size; ++idx)
+            if (left.m_Data[idx] != right.m_Data[idx])
+                return false;
+        return true;
+    }
+    friend constexpr bool operator!=(const InlineVector &left, const InlineVector &right) { return !(left == right); }
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "SpinLock.hpp"
+#include "Utilities.hpp"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Slab allocator for small objects. Memory is requested from the system in aligned chunks, each chunk serves blocks of
+// a single size class, and freed blocks are kept in per-size-class free lists, so both allocation and deallocation are
+// O(1) and only reach the system allocator when a new chunk is needed. Since every chunk is aligned to its own size,
+// the chunk header (and thus the owning pool and the block size) can be found from any block pointer, which makes
+// `Deallocate` not need the pool or the size. The pool is not thread-safe unless it is constructed as synchronized, in
+// which case every operation takes a spin lock, which is cheap as long as allocations are rare compared to the work
+// done between them.
+class MemoryPool : public Util::NonCopyableNonMoveable {
+public:
+    struct Statistics {
+        // The number of blocks and bytes handed out since the pool was created
+        uint64_t Allocations = 0;
+        uint64_t BytesAllocated = 0;
+        // The number of chunks requested from the system since the pool was created
+        uint64_t SystemAllocations = 0;
+        std::size_t BlocksInUse = 0;
+        std::size_t BytesInUse = 0;
+        std::size_t BytesReserved = 0;
+    };
+
+    static constexpr std::size_t ChunkSize = 16 * 1024;
+    static constexpr std::size_t Granularity = 16;
+    static constexpr std::size_t MaxBlockSize = 256;
+
+private:
+    static constexpr std::size_t SizeClassCount = MaxBlockSize / Granularity;
+
+    struct FreeBlock {
+        FreeBlock *Next;
+    };
+
+    struct alignas(Granularity) ChunkHeader {
+        MemoryPool *Owner;
+        unsigned char SizeClass;
+        uint32_t BlocksInUse = 0;
+
+        explicit ChunkHeader(MemoryPool *owner, unsigned char sizeClass) : Owner(owner), SizeClass(sizeClass) {}
+    };
+
+    struct SizeClass {
+        FreeBlock *FreeList = nullptr;
+        // Bump pointer into the most recently allocated chunk of this size class
+        unsigned char *Cursor = nullptr;
+        unsigned char *End = nullptr;
+    };
+
+    std::array<SizeClass, SizeClassCount> m_SizeClasses = {};
+    std::vector<ChunkHeader *> m_Chunks;
+    Statistics m_Statistics;
+    const bool m_Synchronized;
+    mutable SpinLock m_Lock;
+
+    std::unique_lock<SpinLock> Lock() const {
+        return m_Synchronized ? std::unique_lock(m_Lock) : std::unique_lock(m_Lock, std::defer_lock);
+    }
+
+    static constexpr std::size_t GetBlockSize(unsigned char sizeClass) { return (sizeClass + 1) * Granularity; }
+
+    static ChunkHeader *GetChunk(void *ptr) {
+        return reinterpret_cast<ChunkHeader *>(reinterpret_cast<uintptr_t>(ptr) & ~(ChunkSize - 1));
+    }
+
+    void AllocateChunk(unsigned char sizeClass) {
+        void *memory = ::operator new(ChunkSize, std::align_val_t(ChunkSize));
+        const auto chunk = new (memory) ChunkHeader(this, sizeClass);
+        m_Chunks.push_back(chunk);
+        auto &cls = m_SizeClasses[sizeClass];
+        cls.Cursor = static_cast<unsigned char *>(memory) + sizeof(ChunkHeader);
+        cls.End = static_cast<unsigned char *>(memory) + ChunkSize;
+        ++m_Statistics.SystemAllocations;
+        m_Statistics.BytesReserved += ChunkSize;
+    }
+
+    static void FreeChunk(ChunkHeader *chunk) { ::operator delete(chunk, std::align_val_t(ChunkSize)); }
+
+public:
+    explicit MemoryPool(bool synchronized = false) : m_Synchronized(synchronized) {}
+    ~MemoryPool() {
+        // All blocks should have been returned before the pool is destroyed
+        assert(m_Statistics.BlocksInUse == 0);
+        for (const auto chunk : m_Chunks)
+            FreeChunk(chunk);
+    }
+
+    void *Allocate(std::size_t size) {
+        assert(size > 0 && size <= MaxBlockSize);
+        const auto lock = Lock();
+        const unsigned char sizeClass = (size - 1) / Granularity;
+        auto &cls = m_SizeClasses[sizeClass];
+        void *block;
+        if (cls.FreeList) {
+            block = cls.FreeList;
+            cls.FreeList = cls.FreeList->Next;
+        } else {
+            if (cls.Cursor + GetBlockSize(sizeClass) > cls.End)
+                AllocateChunk(sizeClass);
+            block = cls.Cursor;
+            cls.Cursor += GetBlockSize(sizeClass);
+        }
+        ++GetChunk(block)->BlocksInUse;
+        ++m_Statistics.Allocations;
+        m_Statistics.BytesAllocated += GetBlockSize(sizeClass);
+        ++m_Statistics.BlocksInUse;
+        m_Statistics.BytesInUse += GetBlockSize(sizeClass);
+        return block;
+    }
+
+    // Destroys an object created by `New`, and returns its block to the pool it is allocated from
+    struct Deleter {
+        template <typename T>
+        void operator()(T *object) const {
+            object->~T();
+            Deallocate(object);
+        }
+    };
+    template <typename T>
+    using Ptr = std::unique_ptr<T, Deleter>;
+
+    // Construct an object in a block of the pool, which is released by the pointer without referring to the pool
+    template <typename T, typename... TArgs>
+    Ptr<T> New(TArgs &&... args) {
+        static_assert(sizeof(T) <= MaxBlockSize && alignof(T) <= Granularity);
+        void *memory = Allocate(sizeof(T));
+        try {
+            return Ptr<T>(new (memory) T(std::forward<TArgs>(args)...));
+        } catch (...) {
+            Deallocate(memory);
+            throw;
+        }
+    }
+
+    // The pool a block is allocated from
+    static MemoryPool &GetOwner(void *block) { return *GetChunk(block)->Owner; }
+
+    static void Deallocate(void *block) {
+        const auto chunk = GetChunk(block);
+        auto &self = *chunk->Owner;
+        const auto lock = self.Lock();
+        auto &cls = self.m_SizeClasses[chunk->SizeClass];
+        cls.FreeList = new (block) FreeBlock{cls.FreeList};
+        --chunk->BlocksInUse;
+        --self.m_Statistics.BlocksInUse;
+        self.m_Statistics.BytesInUse -= GetBlockSize(chunk->SizeClass);
+    }
+
+    // Return chunks that no longer contain any block in use to the system. This is O(free blocks + chunks) and is meant
+    // to be called after a large part of the objects are released at once, e.g. after pruning a game tree
+    void Compact() {
+        const auto lock = Lock();
+        for (unsigned char sizeClass = 0; sizeClass < SizeClassCount; ++sizeClass) {
+            auto &cls = m_SizeClasses[sizeClass];
+            FreeBlock **link = &cls.FreeList;
+            while (*link) {
+                if (GetChunk(*link)->BlocksInUse == 0)
+                    *link = (*link)->Next;
+                else
+                    link = &(*link)->Next;
+            }
+            // The chunk currently being bumped may be empty too, in which case it is released as well
+            if (cls.Cursor && GetChunk(cls.Cursor - 1)->BlocksInUse == 0)
+                cls.Cursor = cls.End = nullptr;
+        }
+        auto iter = m_Chunks.begin();
+        for (const auto chunk : m_Chunks) {
+            if (chunk->BlocksInUse == 0) {
+                FreeChunk(chunk);
+                m_Statistics.BytesReserved -= ChunkSize;
+            } else
+                *iter++ = chunk;
+        }
+        m_Chunks.erase(iter, m_Chunks.end());
+    }
+
+    Statistics GetStatistics() const {
+        const auto lock = Lock();
+        return m_Statistics;
+    }
+};
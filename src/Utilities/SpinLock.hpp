@@ -0,0 +1,26 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+// A one-byte lock for very short critical sections, e.g. one per node of a shared game tree, where `std::mutex` would be
+// too large and the cost of putting a thread to sleep would exceed the time the lock is held. Meets the `Lockable`
+// requirements, so it can be used with `std::scoped_lock` and `std::unique_lock`.
+class SpinLock {
+private:
+    std::atomic<bool> m_Locked = false;
+
+public:
+    void lock() {
+        while (m_Locked.exchange(true, std::memory_order_acquire))
+            // Spin on a plain load, so that waiting threads do not keep stealing the cache line from the owner
+            while (m_Locked.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+    }
+
+    bool try_lock() {
+        return !m_Locked.load(std::memory_order_relaxed) && !m_Locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() { m_Locked.store(false, std::memory_order_release); }
+};
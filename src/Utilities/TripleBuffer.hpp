@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Passes the latest version of a value from one writer thread to one reader thread, without either of them ever waiting
+// for the other. The writer fills the back buffer and publishes it by swapping it with the middle buffer, and the
+// reader takes the middle buffer in exchange for its front buffer if a newer version has been published since. Each
+// buffer is owned by exactly one side at any time, so the value can be of any type, and is read and written in place.
+// Versions published faster than the reader reads are skipped.
+template <typename T>
+class TripleBuffer {
+private:
+    // Set in the middle index if it holds a version the reader has not taken yet
+    static constexpr uint8_t FreshBit = 4;
+    static constexpr uint8_t IndexMask = 3;
+
+    std::array<T, 3> m_Buffers = {};
+    std::atomic<uint8_t> m_Middle = 1;
+    // Only accessed by the writer
+    uint8_t m_Back = 2;
+    // Only accessed by the reader
+    uint8_t m_Front = 0;
+
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // The buffer to be filled by the writer. It holds an older version, which the writer must overwrite completely
+    T &GetBack() { return m_Buffers[m_Back]; }
+
+    // Make the back buffer the latest version, and give the writer a buffer no longer used by the reader
+    void Publish() { m_Back = m_Middle.exchange(m_Back | FreshBit, std::memory_order_acq_rel) & IndexMask; }
+
+    // The latest version published, which stays valid and unchanged until the reader calls `Read` again. Returns the
+    // default value of `T` if nothing has been published yet
+    const T &Read() {
+        if (m_Middle.load(std::memory_order_relaxed) & FreshBit)
+            m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & IndexMask;
+        return m_Buffers[m_Front];
+    }
+};
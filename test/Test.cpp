@@ -1,6 +1,16 @@
+#include "../src/Games/AbstractGames/MNKGame/BatchedRollout.hpp"
+#include "../src/Games/AbstractGames/MNKGame/Threats.hpp"
+#include "../src/Games/Gomoku/Game.hpp"
+#include "../src/Games/TicTacToe/Game.hpp"
 #include "../src/Server/Server.hpp"
+#include <algorithm>
+#include <chrono>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <thread>
 
 TEST(Test, Case1) {
     Server server(std::cin, std::cout);
@@ -16,8 +26,629 @@ TEST(Test, Case1) {
     std::cout << details << '\n';
 }
 
+TEST(Test, Case3) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":true,"workers":4,"parallelMode":"tree"}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":1})"_json);
+    // The shared tree is pruned while the workers are thinking
+    server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", response["action"]}});
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":1})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    std::cout << details << '\n';
+    EXPECT_GT(details["data"]["totalRollouts"], 0);
+}
+
+TEST(Test, Case4) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":true,"workers":2,"transpositionTableSize":4096}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":1})"_json);
+    // Subtrees shared by transpositions are kept or released when the trees are pruned
+    server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", response["action"]}});
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":1})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    std::cout << details << '\n';
+    EXPECT_TRUE(details["data"].contains("transpositionTable"));
+}
+
+TEST(Test, Case5) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":2000}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    // The subtree of the chosen action is kept, and the iterations of the next search are added on top of it
+    server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", response["action"]}});
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    std::cout << details << '\n';
+    EXPECT_GT(details["data"]["inheritedRollouts"], 0);
+    EXPECT_EQ(details["data"]["totalRollouts"], details["data"]["inheritedRollouts"].get<unsigned int>() + 2000);
+}
+
+TEST(Test, Case6) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"tic_tac_toe","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":1000000,"earlyStop":true}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":true,"workers":2,"earlyStop":true}})"_json);
+    // Leave only the grid (2, 1) empty, without a winner
+    for (const auto &[row, col] : {std::pair(0, 0), {0, 1}, {0, 2}, {1, 1}, {1, 0}, {2, 0}, {1, 2}, {2, 2}})
+        server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", {{"row", row}, {"col", col}}}});
+    // Both players return the only action without searching or waiting for the think time
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto response1 = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":60})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    const auto response2 = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":2,"maxThinkTime":60})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    EXPECT_LT(std::chrono::steady_clock::now() - startTime, std::chrono::seconds(10));
+    EXPECT_EQ(response1["action"], R"({"row":2,"col":1})"_json);
+    EXPECT_EQ(response2["action"], R"({"row":2,"col":1})"_json);
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    EXPECT_EQ(details["data"]["totalRollouts"], 0);
+}
+
+TEST(Test, Case7) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":5000,"maxNodes":1000}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":true,"workers":2,"parallelMode":"tree","maxNodes":1000}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    // The sequential tree collapses its least visited subtrees, and is kept across moves within the limit
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", response["action"]}});
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details1 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    std::cout << details1 << '\n';
+    EXPECT_LE(details1["data"]["memory"]["nodes"], 1000);
+    EXPECT_GT(details1["data"]["memory"]["evictions"], 0);
+    // The shared tree stops expanding, the workers may pass the check at the same time
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":2,"maxThinkTime":1})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    const auto details2 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":2,"data":{}})"_json);
+    std::cout << details2 << '\n';
+    EXPECT_LE(details2["data"]["memory"]["nodes"], 1000 + 2);
+}
+
 TEST(Test, Case2) {
     Server server(std::cin, std::cout);
     server.RunGames(
         R"({"rounds":1,"parallel":false,"game":{"type":"gomoku","data":{}},"players":[{"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":1000},"allowBackgroundThinking":false},{"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":1000},"allowBackgroundThinking":false}]})"_json);
 }
+
+TEST(Test, StateHash) {
+    const gomoku::Game game(nlohmann::json::object());
+    std::mt19937 engine(0);
+    for (unsigned int round = 0; round < 100; ++round) {
+        std::vector<uint8_t> positions(15 * 15);
+        std::iota(positions.begin(), positions.end(), 0);
+        std::shuffle(positions.begin(), positions.end(), engine);
+        positions.resize(20);
+        // The same moves of each player in another order reach the same state
+        auto permuted = positions;
+        for (unsigned int idx = 0; idx + 2 < permuted.size(); idx += 4)
+            std::swap(permuted[idx], permuted[idx + 2]);
+        gomoku::Game::State state, permutedState;
+        for (unsigned int idx = 0; idx < positions.size(); ++idx) {
+            const auto previousHash = state.Hash();
+            game.TakeAction(state, gomoku::Game::Action(positions[idx]));
+            game.TakeAction(permutedState, gomoku::Game::Action(permuted[idx]));
+            EXPECT_NE(state.Hash(), previousHash);
+            EXPECT_EQ(state.Equal(permutedState), state.Hash() == permutedState.Hash());
+            // The key is rebuilt from scratch when a state is loaded
+            const auto loaded = game.CreateState(state.GetJson());
+            EXPECT_TRUE(loaded->Equal(state));
+            EXPECT_EQ(loaded->Hash(), state.Hash());
+        }
+        EXPECT_TRUE(state.Equal(permutedState));
+        EXPECT_EQ(state.Hash(), permutedState.Hash());
+    }
+}
+
+TEST(Test, BatchedRollout) {
+    // Leave only the grid (2, 1) empty, which ends in a draw
+    const tic_tac_toe::Game ticTacToe(nlohmann::json::object());
+    tic_tac_toe::Game::State ticTacToeState;
+    for (const auto &[row, col] : {std::pair(0, 0), {0, 1}, {0, 2}, {1, 1}, {1, 0}, {2, 0}, {1, 2}, {2, 2}})
+        ticTacToe.TakeAction(ticTacToeState, tic_tac_toe::Game::Action(row, col));
+    m_n_k_game::BatchedRollout<3, 3, 3> ticTacToeRollout(std::nullopt);
+    std::vector<const tic_tac_toe::Game::State *> ticTacToeStates(20, &ticTacToeState);
+    std::vector<std::array<float, 2>> results(ticTacToeStates.size());
+    ticTacToeRollout.Run(ticTacToeStates.data(), ticTacToeStates.size(), results.data());
+    for (const auto &result : results)
+        EXPECT_EQ(result, (std::array<float, 2>{0.5f, 0.5f}));
+    // More states than lanes, every game has a winner or is a draw
+    const gomoku::Game gomoku(nlohmann::json::object());
+    gomoku::Game::State gomokuState;
+    gomoku.TakeAction(gomokuState, gomoku::Game::Action(7, 7));
+    m_n_k_game::BatchedRollout<15, 15, 5> gomokuRollout(1);
+    std::vector<const gomoku::Game::State *> gomokuStates(100, &gomokuState);
+    results.resize(gomokuStates.size());
+    gomokuRollout.Run(gomokuStates.data(), gomokuStates.size(), results.data());
+    for (const auto &result : results)
+        EXPECT_EQ(result[0] + result[1], 1.0f);
+    // The MCTS player backpropagates the average of the batched rollouts as one visit
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":1000,"rolloutsPerLeaf":8}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    EXPECT_EQ(details["data"]["totalRollouts"], 1000);
+}
+
+TEST(Test, Threats) {
+    const gomoku::Game game(nlohmann::json::object());
+    gomoku::Game::State state;
+    m_n_k_game::Threats<15, 15, 5> threats;
+    threats.Reset(state);
+    const auto play = [&](unsigned char row, unsigned char col) {
+        const gomoku::Game::Action action(row, col);
+        game.TakeAction(state, action);
+        threats.Update(action.Position, state.GetGrid(action.Position) - 1);
+    };
+    // Player 0 makes an open three on row 0 from (0, 1) to (0, 3), next to the edge of the board, and player 1 makes a
+    // split three on row 5 with a gap at (5, 7)
+    for (const auto &[row, col] : {std::pair(0, 1), {5, 5}, {0, 2}, {5, 6}, {0, 3}, {5, 8}})
+        play(row, col);
+    const auto grids = [&](auto threat, unsigned char player) {
+        std::vector<std::pair<int, int>> result;
+        for (unsigned int position = 0; position < 15 * 15; ++position)
+            if (threats.GetGrids(threat, player)[position])
+                result.emplace_back(position / 15, position % 15);
+        return result;
+    };
+    using Threats = m_n_k_game::Threats<15, 15, 5>;
+    EXPECT_EQ(grids(Threats::OpenFour, 0), (std::vector<std::pair<int, int>>{{0, 4}}));
+    EXPECT_TRUE(grids(Threats::Five, 0).empty());
+    EXPECT_EQ(grids(Threats::OpenFour, 1), (std::vector<std::pair<int, int>>{{5, 7}}));
+    // Then an open four
+    play(0, 4);
+    EXPECT_EQ(grids(Threats::Five, 0), (std::vector<std::pair<int, int>>{{0, 0}, {0, 5}}));
+    // The threats are the same when recomputed from the state
+    Threats recomputed;
+    recomputed.Reset(state);
+    for (const auto threat : {Threats::Five, Threats::OpenFour})
+        for (unsigned char player = 0; player < 2; ++player)
+            EXPECT_EQ(recomputed.GetGrids(threat, player), threats.GetGrids(threat, player));
+    // The threat move player takes the win
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState({{"gameID", 1}, {"data", state.GetJson()}});
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"threat_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":10,"col":10}})"_json);
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    EXPECT_EQ(response["action"]["row"], 0);
+}
+
+TEST(Test, Rave) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"tic_tac_toe","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":2000,"raveEquivalence":100}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":true,"workers":2,"parallelMode":"tree","raveEquivalence":100}})"_json);
+    // The first player wins at (0, 2)
+    for (const auto &[row, col] : {std::pair(1, 2), {1, 1}, {2, 2}, {2, 1}})
+        server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", {{"row", row}, {"col", col}}}});
+    const auto response1 = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    const auto response2 = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":2,"maxThinkTime":0.5})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    EXPECT_EQ(response1["action"], R"({"row":0,"col":2})"_json);
+    EXPECT_EQ(response2["action"], R"({"row":0,"col":2})"_json);
+    // The batched rollouts do not record the actions they play
+    EXPECT_THROW(
+        server.AddPlayer(
+            R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":2000,"raveEquivalence":100,"rolloutsPerLeaf":4}})"_json),
+        std::invalid_argument);
+}
+
+TEST(Test, Solver) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"tic_tac_toe","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":1000000,"solver":true}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":true,"workers":2,"solver":true}})"_json);
+    // The first player wins at (0, 2)
+    for (const auto &[row, col] : {std::pair(1, 2), {1, 1}, {2, 2}, {2, 1}})
+        server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", {{"row", row}, {"col", col}}}});
+    const auto response1 = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto response2 = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":2,"maxThinkTime":10})"_json);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    EXPECT_EQ(response1["action"], R"({"row":0,"col":2})"_json);
+    EXPECT_EQ(response2["action"], R"({"row":0,"col":2})"_json);
+    // Both players stop searching once the win is proven
+    const auto details1 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    const auto details2 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":2,"data":{}})"_json);
+    EXPECT_LT(details1["data"]["totalRollouts"], 1000);
+    EXPECT_EQ(details1["data"]["solver"]["result"], R"([1,0])"_json);
+    EXPECT_EQ(details2["data"]["solver"]["result"], R"([1,0])"_json);
+    EXPECT_LT(elapsed.count(), 1);
+    // The first player must block at (2, 0), which wins, and every other action loses. The actions proven to lose
+    // before the search stops are still reported with their rollouts and exact scores
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":2,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":true,"workers":2,"solver":true}})"_json);
+    for (const auto &[row, col] : {std::pair(0, 0), {1, 1}, {2, 2}, {0, 2}})
+        server.TakeAction({{"gameID", 1}, {"stateID", 2}, {"action", {{"row", row}, {"col", col}}}});
+    server.StartThinking(R"({"gameID":1,"stateID":2,"playerID":1})"_json);
+    const auto response3 = server.GetBestAction(R"({"gameID":1,"stateID":2,"playerID":1,"maxThinkTime":0.3})"_json);
+    const auto details3 = server.QueryDetails(R"({"gameID":1,"stateID":2,"playerID":1,"data":{}})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":2,"playerID":1})"_json);
+    EXPECT_EQ(response3["action"], R"({"row":2,"col":0})"_json);
+    const auto &actions = details3["data"]["actions"];
+    ASSERT_EQ(actions.size(), 5u);
+    for (const auto &action : actions) {
+        EXPECT_GT(action["rollouts"], 0);
+        EXPECT_TRUE(action["score"].is_number());
+    }
+}
+
+TEST(Test, SolverSkipsProvenLosses) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":true,"workers":1,"solver":true}})"_json);
+    // The second player has four in a row, so the first player must block at (7, 11), and every other action loses
+    for (const auto &[row, col] : {std::pair(7, 6), {7, 7}, {0, 0}, {7, 8}, {0, 14}, {7, 9}, {14, 0}, {7, 10}})
+        server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", {{"row", row}, {"col", col}}}});
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":0.5})"_json);
+    const auto details1 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":0.2})"_json);
+    const auto details2 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto block = R"({"row":7,"col":11})"_json;
+    EXPECT_EQ(response["action"], block);
+    EXPECT_GT(details2["data"]["totalRollouts"], details1["data"]["totalRollouts"]);
+    // Once proven, the losses are never selected again, so their rollout counts stop growing
+    std::map<nlohmann::json, unsigned int> lossRollouts;
+    for (const auto &action : details1["data"]["actions"])
+        if (action["action"] != block) {
+            EXPECT_EQ(action["score"], 0.0);
+            lossRollouts[action["action"]] = action["rollouts"];
+        }
+    for (const auto &action : details2["data"]["actions"])
+        if (action["action"] != block) {
+            EXPECT_EQ(action["rollouts"], lossRollouts.at(action["action"]));
+        }
+}
+
+TEST(Test, PartialRootReuse) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"tic_tac_toe","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":3}})"_json);
+    // The root is partially expanded, with the children of the first 3 actions
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":0,"col":1}})"_json);
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details1 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":2,"col":2}})"_json);
+    const auto details2 = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    EXPECT_EQ(details1["data"]["inheritedRollouts"], 1);
+    EXPECT_EQ(details1["data"]["reuse"]["reusedPrunes"], 1);
+    EXPECT_EQ(details2["data"]["reuse"]["prunes"], 2);
+    EXPECT_EQ(details2["data"]["reuse"]["reusedPrunes"], 1);
+    EXPECT_EQ(details2["data"]["reuse"]["reuseRate"], 0.5);
+}
+
+TEST(Test, EarlyStopWithReusedTree) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":1000000,"earlyStop":true}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    const auto response = server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":0.5})"_json);
+    server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", response["action"]}});
+    // The root inherited from the previous search is fully expanded, and the speed is not known before the first
+    // iterations, so the search goes on instead of stopping at once
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1,"maxThinkTime":0.2})"_json);
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json);
+    EXPECT_GT(details["data"]["inheritedRollouts"], 0);
+    EXPECT_GT(details["data"]["totalRollouts"], details["data"]["inheritedRollouts"]);
+}
+
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
+class MNKGame final : public m_n_k_game::Game<RowCount, ColCount, Renju> {
+public:
+    virtual std::string_view GetType() const override { return "m_n_k_game"; }
+};
+
+// Whether the stone of the player on the grid is in a line of `Renju`, walking from it one grid at a time
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
+static bool IsInLine(const typename MNKGame<RowCount, ColCount, Renju>::State &state, unsigned char player, int row,
+                     int col) {
+    for (const auto &[dx, dy] : {std::pair(0, 1), {1, 0}, {1, 1}, {1, -1}}) {
+        const auto isStone = [&](int x, int y) {
+            return 0 <= x && x < RowCount && 0 <= y && y < ColCount && state.GetGrid(x * ColCount + y) == player + 1;
+        };
+        int count = 1;
+        for (int x = row + dx, y = col + dy; isStone(x, y); x += dx, y += dy)
+            ++count;
+        for (int x = row - dx, y = col - dy; isStone(x, y); x -= dx, y -= dy)
+            ++count;
+        if (count >= Renju)
+            return true;
+    }
+    return false;
+}
+
+template <unsigned char RowCount, unsigned char ColCount, unsigned char Renju>
+static void CheckWinDetection(unsigned int gameCount) {
+    using Game = MNKGame<RowCount, ColCount, Renju>;
+    const Game game;
+    // Every line, including the ones along the edges and through the corners, is completed by each of its stones, and
+    // is not completed if one of its stones is the opponent's
+    for (int row = 0; row < RowCount; ++row)
+        for (int col = 0; col < ColCount; ++col)
+            for (const auto &[dx, dy] : {std::pair(0, 1), {1, 0}, {1, 1}, {1, -1}}) {
+                const int endRow = row + (Renju - 1) * dx, endCol = col + (Renju - 1) * dy;
+                if (endRow >= RowCount || endCol < 0 || endCol >= ColCount)
+                    continue;
+                for (int last = 0; last < Renju; ++last)
+                    for (const bool blocked : {false, true}) {
+                        typename Game::State state;
+                        for (int idx = 0; idx < Renju; ++idx)
+                            if (idx != last)
+                                state.SetGrid((row + idx * dx) * ColCount + col + idx * dy,
+                                              blocked && idx == (last + 1) % Renju, false);
+                        const auto result =
+                            game.TakeAction(state, typename Game::Action(row + last * dx, col + last * dy));
+                        EXPECT_EQ(result.has_value(), !blocked) << int(row) << ' ' << int(col) << ' ' << dx << dy;
+                    }
+            }
+    // The same result as walking from the last stone in random games
+    std::mt19937 engine(0);
+    std::vector<typename Game::PosType> positions(RowCount * ColCount);
+    std::iota(positions.begin(), positions.end(), 0);
+    for (unsigned int idx = 0; idx < gameCount; ++idx) {
+        std::shuffle(positions.begin(), positions.end(), engine);
+        typename Game::State state;
+        for (const auto position : positions) {
+            const unsigned char player = state.MoveCount % 2;
+            const auto result = game.TakeAction(state, typename Game::Action(position));
+            const auto win = IsInLine<RowCount, ColCount, Renju>(state, player, position / ColCount,
+                                                                 position % ColCount);
+            ASSERT_EQ(result.has_value(), win || state.MoveCount == RowCount * ColCount);
+            if (result) {
+                EXPECT_EQ((*result)[player], win ? 1.0f : 0.5f);
+                break;
+            }
+        }
+    }
+}
+
+TEST(Test, WinDetection) {
+    CheckWinDetection<3, 3, 3>(1000);
+    CheckWinDetection<15, 15, 5>(200);
+    CheckWinDetection<4, 7, 4>(500);
+    CheckWinDetection<8, 8, 5>(500);
+    CheckWinDetection<1, 9, 4>(100);
+}
+
+TEST(Test, ActionGenerators) {
+    using Game = gomoku::Game;
+    const Game game(nlohmann::json::object());
+    // Shifting the grids drops the ones moved off the board instead of wrapping them around into another row
+    Game::BitBoard corners;
+    for (const auto position : {0, 14, 210, 224})
+        corners.Set(position);
+    for (int rowOffset = -2; rowOffset <= 2; ++rowOffset)
+        for (int colOffset = -2; colOffset <= 2; ++colOffset) {
+            const auto shifted = Game::ShiftGrids(corners, rowOffset, colOffset);
+            Game::BitBoard expected;
+            for (const auto &[row, col] : {std::pair(0, 0), {0, 14}, {14, 0}, {14, 14}})
+                if (row + rowOffset >= 0 && row + rowOffset < 15 && col + colOffset >= 0 && col + colOffset < 15)
+                    expected.Set((row + rowOffset) * 15 + col + colOffset);
+            EXPECT_EQ(shifted, expected) << rowOffset << ' ' << colOffset;
+        }
+    // The actions are the empty grids within range of a stone, or the center if it's empty, whether the data is updated
+    // move by move or computed from the state
+    for (const unsigned char range : {1, 2}) {
+        const auto neighbor = ActionGenerator::Create("neighbor", game, {{"range", range}});
+        const auto defaultGenerator = ActionGenerator::Create("default", game, nlohmann::json::object());
+        std::mt19937 engine(range);
+        Game::State state;
+        auto data = neighbor->CreateData(state);
+        const auto defaultData = defaultGenerator->CreateData(state);
+        for (unsigned int move = 0; move < 60; ++move) {
+            std::vector<unsigned int> expected, defaultExpected;
+            for (int row = 0; row < 15; ++row)
+                for (int col = 0; col < 15; ++col) {
+                    if (state.GetGrid(row * 15 + col) != 0)
+                        continue;
+                    defaultExpected.push_back(row * 15 + col);
+                    bool inRange = row == 7 && col == 7;
+                    for (int x = std::max(0, row - range); x <= std::min(14, row + range); ++x)
+                        for (int y = std::max(0, col - range); y <= std::min(14, col + range); ++y)
+                            inRange |= state.GetGrid(x * 15 + y) != 0;
+                    if (inRange)
+                        expected.push_back(row * 15 + col);
+                }
+            const auto actions = [&](const ActionGenerator &actionGenerator, const ActionGenerator::Data &data) {
+                std::vector<unsigned int> result;
+                for (const auto &action : actionGenerator.GetActionList(data, state))
+                    result.push_back(static_cast<const Game::Action &>(*action).Position);
+                EXPECT_EQ(result.size(), actionGenerator.GetActionCount(data, state));
+                return result;
+            };
+            EXPECT_EQ(actions(*neighbor, *data), expected);
+            EXPECT_TRUE(neighbor->CreateData(state)->Equal(*data));
+            EXPECT_EQ(actions(*defaultGenerator, *defaultData), defaultExpected);
+            const auto action = neighbor->GetRandomAction(*data, state);
+            if (game.TakeAction(state, *action))
+                break;
+            neighbor->UpdateData(*data, state, *action);
+        }
+    }
+}
+
+TEST(Test, Replay) {
+    // Undoing the actions in reverse order brings back every state and action generator data on the way
+    const gomoku::Game game(nlohmann::json::object());
+    const auto neighbor = ActionGenerator::Create("neighbor", game, {{"range", 2}});
+    ASSERT_TRUE(game.CanUndo());
+    std::mt19937 engine(0);
+    gomoku::Game::State state;
+    auto data = neighbor->CreateData(state);
+    std::vector<std::unique_ptr<Game::State>> states;
+    std::vector<std::unique_ptr<ActionGenerator::Data>> datas;
+    std::vector<Game::ActionValue> actions;
+    std::vector<std::unique_ptr<ActionGenerator::UndoData>> undoDatas;
+    while (true) {
+        auto action = neighbor->GetRandomAction(*data, state);
+        auto undoData = neighbor->CreateUndoData();
+        ASSERT_TRUE(undoData);
+        states.push_back(state.Clone());
+        datas.push_back(data->Clone());
+        // The action that ends the game is undone right away, the same as the search does
+        if (game.TakeAction(state, *action)) {
+            game.UndoAction(state, *action);
+            EXPECT_TRUE(state.Equal(*states.back()));
+            break;
+        }
+        neighbor->SaveUndoData(*data, *undoData);
+        neighbor->UpdateData(*data, state, *action);
+        actions.push_back(std::move(action));
+        undoDatas.push_back(std::move(undoData));
+    }
+    for (auto idx = actions.size(); idx-- > 0;) {
+        neighbor->UndoUpdateData(*data, *undoDatas[idx]);
+        game.UndoAction(state, *actions[idx]);
+        EXPECT_TRUE(state.Equal(*states[idx]));
+        EXPECT_EQ(state.Hash(), states[idx]->Hash());
+        EXPECT_TRUE(data->Equal(*datas[idx]));
+    }
+    // The searches that replay the actions from the root find the same win, in every parallel mode and when the trees
+    // are collapsed to fit the node limit
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"tic_tac_toe","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":5000,"replay":true,"solver":true}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":5000,"replay":true,"maxNodes":64}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":true,"workers":2,"replay":true}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":true,"workers":2,"parallelMode":"tree","replay":true}})"_json);
+    for (const auto playerID : {1, 2})
+        server.GetBestAction({{"gameID", 1}, {"stateID", 1}, {"playerID", playerID}});
+    const auto details = server.QueryDetails(R"({"gameID":1,"stateID":1,"playerID":2,"data":{}})"_json);
+    EXPECT_GT(details["data"]["memory"]["evictions"], 0);
+    // The first player wins at (0, 2)
+    for (const auto &[row, col] : {std::pair(1, 2), {1, 1}, {2, 2}, {2, 1}})
+        server.TakeAction({{"gameID", 1}, {"stateID", 1}, {"action", {{"row", row}, {"col", col}}}});
+    for (const auto playerID : {1, 2}) {
+        const auto response = server.GetBestAction({{"gameID", 1}, {"stateID", 1}, {"playerID", playerID}});
+        EXPECT_EQ(response["action"], R"({"row":0,"col":2})"_json);
+    }
+    for (const auto playerID : {3, 4}) {
+        server.StartThinking({{"gameID", 1}, {"stateID", 1}, {"playerID", playerID}});
+        const auto response =
+            server.GetBestAction({{"gameID", 1}, {"stateID", 1}, {"playerID", playerID}, {"maxThinkTime", 0.5}});
+        server.StopThinking({{"gameID", 1}, {"stateID", 1}, {"playerID", playerID}});
+        EXPECT_EQ(response["action"], R"({"row":0,"col":2})"_json);
+    }
+    // Several paths lead to the same node in a transposition table, but each node keeps only one action
+    EXPECT_THROW(
+        server.AddPlayer(
+            R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"default","data":{}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"default","data":{}}}},"parallel":false,"iterations":5000,"replay":true,"transpositionTableSize":1024}})"_json),
+        std::invalid_argument);
+}
+
+TEST(Test, PublishedReports) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":true,"workers":2}})"_json);
+    const auto request = R"({"gameID":1,"stateID":1,"playerID":1,"data":{}})"_json;
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    // The progress of the search is seen while thinking, and never goes back
+    unsigned int lastRollouts = 0;
+    for (int poll = 0; poll < 50; ++poll) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        const unsigned int rollouts = server.QueryDetails(request)["data"]["totalRollouts"];
+        EXPECT_GE(rollouts, lastRollouts);
+        lastRollouts = rollouts;
+    }
+    EXPECT_GT(lastRollouts, 0u);
+    // All iterations are reported once thinking is stopped
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    const auto details1 = server.QueryDetails(request);
+    const auto details2 = server.QueryDetails(request);
+    EXPECT_EQ(details1, details2);
+    EXPECT_GE(details1["data"]["totalRollouts"], lastRollouts);
+    // The reports are of the new root right after the action is taken
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":8,"col":8}})"_json);
+    const auto details3 = server.QueryDetails(request);
+    EXPECT_EQ(details3["data"]["reuse"]["prunes"], 4);
+    EXPECT_EQ(details3["data"]["reuse"]["reusedPrunes"], 2);
+}
+
+#ifdef MCTS_INSTRUMENTATION
+TEST(Test, Instrumentation) {
+    Server server(std::cin, std::cout);
+    server.AddGame(R"({"type":"gomoku","data":{}})"_json);
+    server.AddState(R"({"gameID":1})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":false,"iterations":1000}})"_json);
+    server.AddPlayer(
+        R"({"gameID":1,"stateID":1,"type":"mcts","data":{"explorationFactor":1,"goalMatrix":[[1,0],[0,1]],"actionGenerator":{"type":"neighbor","data":{"range":1}},"rolloutPlayer":{"type":"random_move","data":{"actionGenerator":{"type":"neighbor","data":{"range":1}}}},"parallel":true,"workers":2}})"_json);
+    server.TakeAction(R"({"gameID":1,"stateID":1,"action":{"row":7,"col":7}})"_json);
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":1})"_json);
+    server.StartThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    server.GetBestAction(R"({"gameID":1,"stateID":1,"playerID":2,"maxThinkTime":0.5})"_json);
+    server.StopThinking(R"({"gameID":1,"stateID":1,"playerID":2})"_json);
+    for (const auto playerID : {1, 2}) {
+        const auto details = server.QueryDetails({{"gameID", 1}, {"stateID", 1}, {"playerID", playerID}, {"data", {}}});
+        const auto &instrumentation = details["data"]["instrumentation"];
+        // Every node of the trees is counted by its type
+        int64_t nodeCount = 0;
+        for (const auto &[type, count] : instrumentation["nodes"].items())
+            nodeCount += count.get<int64_t>();
+        EXPECT_EQ(nodeCount, details["data"]["memory"]["nodes"]);
+        EXPECT_GT(instrumentation["iterationsPerSecond"], 0);
+        EXPECT_GT(instrumentation["phaseSeconds"]["rollout"], instrumentation["phaseSeconds"]["select"]);
+        EXPECT_GE(instrumentation["maxDepth"], instrumentation["meanDepth"]);
+        if (playerID == 1) {
+            EXPECT_EQ(instrumentation["iterations"], 1000);
+        }
+    }
+}
+#endif